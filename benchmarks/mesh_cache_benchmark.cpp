@@ -0,0 +1,126 @@
+#include "lve_mesh_cache.hpp"
+#include "lve_model.hpp"
+
+// std
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Cold and warm load times of LveModel::Builder::loadCached, the part of
+// LveModel::createModelFromFile that runs before the upload. Cold loads parse, optimize and
+// build meshlets with the sidecar deleted first, warm loads read the sidecar the cold ones wrote.
+//
+// Usage: lve_mesh_cache_benchmark [iterations] [model.obj...], all bundled models by default.
+
+namespace
+{
+    struct Timing
+    {
+        double averageMs{0.0};
+        double bestMs{0.0};
+    };
+
+    template <typename Load>
+    Timing measure(uint32_t iterations, const Load &load)
+    {
+        Timing timing{};
+        timing.bestMs = std::numeric_limits<double>::max();
+        for (uint32_t i{0}; i < iterations; ++i)
+        {
+            auto startTime{std::chrono::steady_clock::now()};
+            load();
+            double ms{std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count()};
+            timing.averageMs += ms / iterations;
+            timing.bestMs = std::min(timing.bestMs, ms);
+        }
+        return timing;
+    }
+
+    void removeSidecar(const std::string &modelPath)
+    {
+        std::error_code error{};
+        std::filesystem::remove(lve::LveMeshCache::cachePath(modelPath), error);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations{10};
+    std::vector<std::string> modelPaths{};
+    for (int i{1}; i < argc; ++i)
+    {
+        if (i == 1 && std::isdigit(static_cast<unsigned char>(argv[i][0])))
+        {
+            iterations = std::max(static_cast<uint32_t>(std::strtoul(argv[i], nullptr, 10)), 1u);
+        }
+        else
+        {
+            modelPaths.push_back(argv[i]);
+        }
+    }
+    if (modelPaths.empty())
+    {
+        for (const auto &entry : std::filesystem::directory_iterator{LVE_MODELS_DIR})
+        {
+            if (entry.path().extension() == ".obj")
+            {
+                modelPaths.push_back(entry.path().string());
+            }
+        }
+        std::sort(modelPaths.begin(), modelPaths.end());
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << iterations << " iterations, times in ms (average / best)\n";
+
+    try
+    {
+        for (const auto &modelPath : modelPaths)
+        {
+            size_t vertexCount{0};
+            Timing cold{measure(
+                iterations,
+                [&]()
+                {
+                    removeSidecar(modelPath);
+                    lve::LveModel::Builder builder{};
+                    if (builder.loadCached(modelPath, true))
+                    {
+                        throw std::runtime_error("Sidecar was used for a cold load: " + modelPath);
+                    }
+                    vertexCount = builder.vertices.size();
+                })};
+            Timing warm{measure(
+                iterations,
+                [&]()
+                {
+                    lve::LveModel::Builder builder{};
+                    if (!builder.loadCached(modelPath, true))
+                    {
+                        throw std::runtime_error("Sidecar was not used for a warm load: " + modelPath);
+                    }
+                })};
+
+            std::cout << std::filesystem::path{modelPath}.filename().string() << ": " << vertexCount
+                      << " vertices, cold " << cold.averageMs << " / " << cold.bestMs << ", warm "
+                      << warm.averageMs << " / " << warm.bestMs << ", " << std::setprecision(1)
+                      << cold.averageMs / std::max(warm.averageMs, 1e-6) << "x\n"
+                      << std::setprecision(3);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+#include "lve_mesh_optimizer.hpp"
+#include "lve_model.hpp"
+
+// std
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Time of each LveMeshOptimizer pass and the vertex cache figures after it, on the CPU. Every
+// iteration starts over from the loaded model, times are the best of all iterations.
+//
+// Usage: lve_mesh_optimizer_benchmark [iterations] [model.obj...], all bundled models by default.
+
+namespace
+{
+    using lve::LveMeshOptimizer;
+    using lve::LveModel;
+
+    template <typename Pass>
+    double timePass(const Pass &pass)
+    {
+        auto startTime{std::chrono::steady_clock::now()};
+        pass();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    void printStage(const char *stage, const LveModel::Builder &builder, double bestMs)
+    {
+        const auto stats{LveMeshOptimizer::analyzeVertexCache(builder.indices, builder.vertices.size())};
+        std::cout << "  " << std::left << std::setw(12) << stage << std::right << "ACMR " << stats.acmr
+                  << ", ATVR " << stats.atvr;
+        if (bestMs >= 0.0)
+        {
+            std::cout << ", " << bestMs << " ms";
+        }
+        std::cout << '\n';
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations{10};
+    std::vector<std::string> modelPaths{};
+    for (int i{1}; i < argc; ++i)
+    {
+        if (i == 1 && std::isdigit(static_cast<unsigned char>(argv[i][0])))
+        {
+            iterations = std::max(static_cast<uint32_t>(std::strtoul(argv[i], nullptr, 10)), 1u);
+        }
+        else
+        {
+            modelPaths.push_back(argv[i]);
+        }
+    }
+    if (modelPaths.empty())
+    {
+        for (const auto &entry : std::filesystem::directory_iterator{LVE_MODELS_DIR})
+        {
+            if (entry.path().extension() == ".obj")
+            {
+                modelPaths.push_back(entry.path().string());
+            }
+        }
+        std::sort(modelPaths.begin(), modelPaths.end());
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << iterations << " iterations, best times\n";
+
+    for (const auto &modelPath : modelPaths)
+    {
+        LveModel::Builder loaded{};
+        loaded.loadModel(modelPath);
+
+        double vertexCacheMs{std::numeric_limits<double>::max()};
+        double overdrawMs{std::numeric_limits<double>::max()};
+        double vertexFetchMs{std::numeric_limits<double>::max()};
+        LveModel::Builder afterVertexCache{};
+        LveModel::Builder afterOverdraw{};
+        LveModel::Builder builder{};
+        for (uint32_t i{0}; i < iterations; ++i)
+        {
+            builder = loaded;
+            vertexCacheMs = std::min(
+                vertexCacheMs,
+                timePass([&]() { LveMeshOptimizer::optimizeVertexCache(builder.indices, builder.vertices.size()); }));
+            afterVertexCache = builder;
+            overdrawMs = std::min(
+                overdrawMs, timePass([&]() { LveMeshOptimizer::optimizeOverdraw(builder.indices, builder.vertices); }));
+            afterOverdraw = builder;
+            vertexFetchMs = std::min(
+                vertexFetchMs,
+                timePass([&]() { LveMeshOptimizer::optimizeVertexFetch(builder.vertices, builder.indices); }));
+        }
+
+        std::cout << std::filesystem::path{modelPath}.filename().string() << ": " << loaded.vertices.size()
+                  << " vertices, " << loaded.indices.size() / 3 << " triangles\n";
+        printStage("loaded", loaded, -1.0);
+        printStage("tipsify", afterVertexCache, vertexCacheMs);
+        printStage("overdraw", afterOverdraw, overdrawMs);
+        // renumbering leaves the cache figures as they were
+        printStage("fetch", builder, vertexFetchMs);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+#include "lve_obj_parser.hpp"
+
+#ifdef LVE_HAS_TINYOBJ
+#include "tinyobj_reference.hpp"
+#endif
+
+// std
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Parse time and throughput of LveObjParser, and of the tinyobj based loader it replaced when
+// tinyobj was found at configure time. Both produce deduplicated vertices and indices, so the
+// numbers compare the whole path from file to Builder contents.
+//
+// Usage: lve_obj_parser_benchmark [iterations] [model.obj...], all bundled models by default.
+
+namespace
+{
+    using Loader = std::function<void(
+        const std::string &filePath, std::vector<lve::LveModel::Vertex> &vertices, std::vector<uint32_t> &indices)>;
+
+    void report(const std::string &name, const std::string &modelPath, uint32_t iterations, const Loader &load)
+    {
+        std::vector<lve::LveModel::Vertex> vertices{};
+        std::vector<uint32_t> indices{};
+        double averageMs{0.0};
+        double bestMs{std::numeric_limits<double>::max()};
+        for (uint32_t i{0}; i < iterations; ++i)
+        {
+            auto startTime{std::chrono::steady_clock::now()};
+            load(modelPath, vertices, indices);
+            double ms{std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count()};
+            averageMs += ms / iterations;
+            bestMs = std::min(bestMs, ms);
+        }
+
+        const double megabytes{static_cast<double>(std::filesystem::file_size(modelPath)) / (1024.0 * 1024.0)};
+        std::cout << "  " << std::left << std::setw(8) << name << std::right << averageMs << " / " << bestMs
+                  << " ms, " << megabytes / (std::max(bestMs, 1e-6) / 1000.0) << " MB/s, " << vertices.size()
+                  << " vertices, " << indices.size() << " indices\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations{20};
+    std::vector<std::string> modelPaths{};
+    for (int i{1}; i < argc; ++i)
+    {
+        if (i == 1 && std::isdigit(static_cast<unsigned char>(argv[i][0])))
+        {
+            iterations = std::max(static_cast<uint32_t>(std::strtoul(argv[i], nullptr, 10)), 1u);
+        }
+        else
+        {
+            modelPaths.push_back(argv[i]);
+        }
+    }
+    if (modelPaths.empty())
+    {
+        for (const auto &entry : std::filesystem::directory_iterator{LVE_MODELS_DIR})
+        {
+            if (entry.path().extension() == ".obj")
+            {
+                modelPaths.push_back(entry.path().string());
+            }
+        }
+        std::sort(modelPaths.begin(), modelPaths.end());
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << iterations << " iterations, times in ms (average / best), throughput of the best\n";
+
+    try
+    {
+        for (const auto &modelPath : modelPaths)
+        {
+            std::cout << std::filesystem::path{modelPath}.filename().string() << ":\n";
+            report(
+                "lve",
+                modelPath,
+                iterations,
+                [](const std::string &filePath, std::vector<lve::LveModel::Vertex> &vertices, std::vector<uint32_t> &indices)
+                { lve::LveObjParser{filePath}.parse(vertices, indices); });
+#ifdef LVE_HAS_TINYOBJ
+            report("tinyobj", modelPath, iterations, lve::reference::loadWithTinyObj);
+#endif
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -6,8 +6,16 @@
 #include "lve_renderer.hpp"
 #include "simple_render_system.hpp"
 #include "lve_descriptors.hpp"
+#include "lve_frame_readback.hpp"
+#include "lve_frame_ring_buffer.hpp"
+#include "lve_frame_writer.hpp"
+#include "lve_geometry_arena.hpp"
+#include "lve_residency_manager.hpp"
+#include "lve_thread_pool.hpp"
+#include "lve_upload_batcher.hpp"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace lve
@@ -19,7 +27,13 @@ namespace lve
         static constexpr int WIDTH{800};
         static constexpr int HEIGHT{600};
 
-        FirstApp();
+        // With a headlessFrameCount no window is opened, run() renders that many frames offscreen
+        // and reports the frame time. With a captureDirectory every frame is read back and written
+        // there as a PNG.
+        FirstApp(
+            const LveFrameSettings &frameSettings = {},
+            uint32_t headlessFrameCount = 0,
+            const std::string &captureDirectory = "");
         ~FirstApp();
 
         FirstApp(const FirstApp &) = delete;
@@ -29,12 +43,29 @@ namespace lve
 
     private:
         void loadGameObjects();
+        // Recreates the frame ring for frameCount frames and points the global set at it.
+        void createFrameRing(uint32_t frameCount);
 
-        LveWindow lveWindow{WIDTH, HEIGHT, "Hello Vulkan!"};
-        LveDevice lveDevice{lveWindow};
-        LveRenderer lveRenderer{lveWindow, lveDevice};
+        // Per-frame uniform data of all frames in flight.
+        static constexpr VkDeviceSize FRAME_RING_SIZE{64 * 1024};
+
+        uint32_t headlessFrameCount;
+        std::string captureDirectory;
+        // Null when headless.
+        std::unique_ptr<LveWindow> lveWindow;
+        LveDevice lveDevice{lveWindow.get()};
+        LveThreadPool threadPool{};
+        std::unique_ptr<LveRenderer> lveRenderer;
+        LveUploadBatcher uploadBatcher{lveDevice};
+        // declared before gameObjects so models release their ranges before it is destroyed
+        LveGeometryArena geometryArena{lveDevice, uploadBatcher};
+        LveResidencyManager residencyManager{lveDevice, geometryArena, uploadBatcher};
 
         std::unique_ptr<LveDescriptorPool> globalPool{};
+        std::unique_ptr<LveDescriptorSetLayout> globalSetLayout{};
+        // one set for all frames, the dynamic offset selects the frame's data
+        VkDescriptorSet globalDescriptorSet{VK_NULL_HANDLE};
+        std::unique_ptr<LveFrameRingBuffer> frameRing{};
         std::vector<LveGameObject> gameObjects;
     };
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "lve_device.hpp"
 
+#include <vector>
+
 namespace lve
 {
 
@@ -23,8 +25,15 @@ namespace lve
         VkResult map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
         void unmap();
 
+        // Writes are recorded as dirty ranges on non-coherent memory, commit() makes them visible.
         void writeToBuffer(const void *data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+        // Flushes one range right away, dropping it from what commit() still has to flush. Prefer
+        // writes followed by a single commit().
         VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+        // Flushes every range written since the last commit with one driver call.
+        VkResult commit();
+        // Records a write made directly through getMappedMemory() for the next commit().
+        void markDirty(VkDeviceSize size, VkDeviceSize offset);
         VkDescriptorBufferInfo descriptorInfo(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
         VkResult invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
 
@@ -40,6 +49,7 @@ namespace lve
         VkDeviceSize getAlignmentSize() const { return instanceSize; }
         VkBufferUsageFlags getUsageFlags() const { return usageFlags; }
         VkMemoryPropertyFlags getMemoryPropertyFlags() const { return memoryPropertyFlags; }
+        bool isCoherent() const { return allocation.propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT; }
         VkDeviceSize getBufferSize() const { return bufferSize; }
 
     private:
@@ -48,7 +58,18 @@ namespace lve
         LveDevice &lveDevice;
         void *mapped = nullptr;
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        LveAllocation allocation{};
+
+        struct DirtyRange
+        {
+            VkDeviceSize begin;
+            VkDeviceSize end;
+        };
+        // Buffer relative, widened to nonCoherentAtomSize boundaries of the underlying memory.
+        std::vector<DirtyRange> dirtyRanges{};
+
+        DirtyRange atomRange(VkDeviceSize size, VkDeviceSize offset) const;
+        void clearDirty(VkDeviceSize size, VkDeviceSize offset);
 
         VkDeviceSize bufferSize;
         uint32_t instanceCount;
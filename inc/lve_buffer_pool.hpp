@@ -0,0 +1,68 @@
+#pragma once
+
+#include "lve_memory_allocator.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <mutex>
+
+namespace lve
+{
+    // Keeps buffers the GPU is done with so later buffers of the same size, usage and memory
+    // properties reuse them instead of going through vkCreateBuffer and the allocator again, which
+    // streaming and readback churn through every frame. Large buffers are never pooled, and past
+    // the capacity the oldest pooled ones are destroyed.
+    class LveBufferPool
+    {
+    public:
+        static constexpr VkDeviceSize MAX_BUFFER_SIZE{4 * 1024 * 1024};
+        static constexpr VkDeviceSize CAPACITY{64 * 1024 * 1024};
+
+        LveBufferPool(VkDevice device, LveMemoryAllocator &allocator);
+        ~LveBufferPool();
+
+        LveBufferPool(const LveBufferPool &) = delete;
+        LveBufferPool &operator=(const LveBufferPool &) = delete;
+
+        // Hands out a pooled buffer matching exactly, returns false when there is none. Thread safe.
+        bool acquire(
+            VkDeviceSize size,
+            VkBufferUsageFlags usage,
+            VkMemoryPropertyFlags properties,
+            VkBuffer &buffer,
+            LveAllocation &allocation);
+        // Takes ownership of a buffer the GPU no longer uses, destroying it if it cannot be pooled.
+        // Thread safe.
+        void release(
+            VkDeviceSize size,
+            VkBufferUsageFlags usage,
+            VkMemoryPropertyFlags properties,
+            VkBuffer buffer,
+            LveAllocation allocation);
+        // Destroys every pooled buffer.
+        void clear();
+
+        VkDeviceSize getPooledSize();
+
+    private:
+        struct Entry
+        {
+            VkDeviceSize size{0};
+            VkBufferUsageFlags usage{0};
+            VkMemoryPropertyFlags properties{0};
+            VkBuffer buffer{VK_NULL_HANDLE};
+            LveAllocation allocation{};
+        };
+
+        void destroy(Entry &entry);
+
+        VkDevice device;
+        LveMemoryAllocator &allocator;
+
+        std::mutex mutex{};
+        // Oldest first, evicted from the front.
+        std::deque<Entry> entries{};
+        VkDeviceSize pooledSize{0};
+    };
+}
@@ -21,9 +21,12 @@ namespace lve
 
         const glm::mat4 &getProjection() const { return projectionMatrix; }
         const glm::mat4 &getView() const { return viewMatrix; }
+        const glm::mat4 &getInverseView() const { return inverseViewMatrix; }
+        const glm::vec3 getPosition() const { return glm::vec3(inverseViewMatrix[3]); }
 
     private:
         glm::mat4 projectionMatrix{1.f};
         glm::mat4 viewMatrix{1.f};
+        glm::mat4 inverseViewMatrix{1.f};
     };
 }
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "lve_timeline.hpp"
+
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace lve
+{
+    // Defers destroying objects the GPU may still be using until the frames that could use them
+    // have completed on the graphics timeline, instead of waiting for the device to go idle.
+    class LveDeletionQueue
+    {
+    public:
+        explicit LveDeletionQueue(LveTimeline &frameTimeline);
+        ~LveDeletionQueue();
+
+        LveDeletionQueue(const LveDeletionQueue &) = delete;
+        LveDeletionQueue &operator=(const LveDeletionQueue &) = delete;
+
+        // Runs deleter once every frame submitted so far, and the one being recorded, has
+        // completed. Thread safe.
+        void push(std::function<void()> deleter);
+        // Runs the deleters whose frames have completed, call once per frame.
+        void collect();
+        // Runs every remaining deleter, the device must be idle.
+        void flush();
+
+    private:
+        struct Entry
+        {
+            uint64_t frame{0};
+            std::function<void()> deleter{};
+        };
+
+        // Deleters may push further entries, so they run outside the lock.
+        void run(std::deque<Entry> &ready);
+
+        LveTimeline &frameTimeline;
+        std::mutex mutex{};
+        // Frame values never decrease, so ready entries are always at the front.
+        std::deque<Entry> entries{};
+    };
+}
@@ -1,8 +1,13 @@
 #pragma once
 
 #include "lve_window.hpp"
+#include "lve_buffer_pool.hpp"
+#include "lve_deletion_queue.hpp"
+#include "lve_memory_allocator.hpp"
+#include "lve_timeline.hpp"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -20,9 +25,13 @@ namespace lve
     {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        // A transfer only family when the device has one, the graphics family otherwise.
+        uint32_t transferFamily;
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
+        bool transferFamilyHasValue = false;
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
+        bool hasDedicatedTransfer() { return transferFamilyHasValue && transferFamily != graphicsFamily; }
     };
 
     class LveDevice
@@ -34,7 +43,10 @@ namespace lve
         const bool enableValidationLayers = true;
 #endif
 
-        LveDevice(LveWindow &window);
+        LveDevice(LveWindow &window) : LveDevice{&window} {}
+        // Headless without a window: no surface is created and devices without present support,
+        // such as software rasterizers, qualify too.
+        explicit LveDevice(LveWindow *window);
         ~LveDevice();
 
         // Not copyable or movable
@@ -43,11 +55,13 @@ namespace lve
         LveDevice(LveDevice &&) = delete;
         LveDevice &operator=(LveDevice &&) = delete;
 
-        VkCommandPool getCommandPool() { return commandPool; }
         VkDevice device() { return device_; }
         VkSurfaceKHR surface() { return surface_; }
+        bool isHeadless() const { return window == nullptr; }
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
+        // Same as graphicsQueue() without a dedicated transfer family.
+        VkQueue transferQueue() { return transferQueue_; }
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -56,15 +70,32 @@ namespace lve
             const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
         // Buffer Helper Functions
+        // Memory comes from memoryAllocator(), possibly with a recycled buffer from bufferPool().
+        // Release both with destroyBuffer, passing the same size, usage and properties.
         void createBuffer(
             VkDeviceSize size,
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer &buffer,
-            VkDeviceMemory &bufferMemory);
+            LveAllocation &allocation);
+        // Hands the buffer to the buffer pool, or destroys it, once the frames that may use it have
+        // completed. Thread safe.
+        void destroyBuffer(
+            VkDeviceSize size,
+            VkBufferUsageFlags usage,
+            VkMemoryPropertyFlags properties,
+            VkBuffer buffer,
+            LveAllocation allocation);
+        // Records into the device's one-off transfer command buffer, which endSingleTimeCommands
+        // submits and waits for. Only one may be in progress at a time.
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+        void copyBuffer(
+            VkBuffer srcBuffer,
+            VkBuffer dstBuffer,
+            VkDeviceSize size,
+            VkDeviceSize srcOffset = 0,
+            VkDeviceSize dstOffset = 0);
         void copyBufferToImage(
             VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
@@ -72,7 +103,20 @@ namespace lve
             const VkImageCreateInfo &imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage &image,
-            VkDeviceMemory &imageMemory);
+            LveAllocation &allocation);
+        void freeMemory(LveAllocation &allocation) { memoryAllocator_->free(allocation); }
+        LveMemoryAllocator &memoryAllocator() { return *memoryAllocator_; }
+        LveBufferPool &bufferPool() { return *bufferPool_; }
+        bool hasMemoryBudget() const { return memoryBudgetEnabled; }
+
+        // Signaled by frame submissions only, so value N means frame N has completed.
+        LveTimeline &graphicsTimeline() { return *graphicsTimeline_; }
+        // Signaled by upload submissions to transferQueue(), a separate semaphore even when that
+        // is the graphics queue.
+        LveTimeline &transferTimeline() { return *transferTimeline_; }
+        // Releases objects once the frames that may use them have completed, drained when the
+        // device is destroyed.
+        LveDeletionQueue &deletionQueue() { return *deletionQueue_; }
 
         VkPhysicalDeviceProperties properties;
 
@@ -82,6 +126,8 @@ namespace lve
         void createSurface();
         void pickPhysicalDevice();
         void createLogicalDevice();
+        void createMemoryAllocator();
+        void createTimelines();
         void createCommandPool();
 
         // helper functions
@@ -92,18 +138,35 @@ namespace lve
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
         void hasGlfwRequiredInstanceExtensions();
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        bool hasInstanceExtension(const char *name);
+        bool hasDeviceExtension(VkPhysicalDevice device, const char *name);
+        // Core in Vulkan 1.2, VK_KHR_timeline_semaphore before.
+        bool supportsTimelineSemaphores(VkPhysicalDevice device);
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-        LveWindow &window;
-        VkCommandPool commandPool;
+        LveWindow *window;
+        // Only for single time commands, reset as a whole before each one.
+        VkCommandPool transferCommandPool;
+        VkCommandBuffer transferCommandBuffer;
+        bool singleTimeCommandsActive = false;
 
         VkDevice device_;
-        VkSurfaceKHR surface_;
+        VkSurfaceKHR surface_ = VK_NULL_HANDLE;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_;
+        std::unique_ptr<LveMemoryAllocator> memoryAllocator_;
+        std::unique_ptr<LveBufferPool> bufferPool_;
+        std::unique_ptr<LveTimeline> graphicsTimeline_;
+        std::unique_ptr<LveTimeline> transferTimeline_;
+        std::unique_ptr<LveDeletionQueue> deletionQueue_;
+        bool properties2Enabled = false;
+        bool memoryBudgetEnabled = false;
+        // Set when the device is older than 1.2 and the timeline functions carry the KHR suffix.
+        bool timelineExtensionEnabled = false;
 
         const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
         const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
@@ -13,5 +13,8 @@ namespace lve
         VkCommandBuffer commandBuffer;
         LveCamera &camera;
         VkDescriptorSet globalDescriptorSet;
+        // Dynamic offset of this frame's GlobalUbo within the global set's buffer.
+        uint32_t globalUboOffset;
+        VkExtent2D extent;
     };
 }
\ No newline at end of file
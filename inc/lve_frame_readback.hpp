@@ -0,0 +1,81 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+#include "lve_renderer.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace lve
+{
+    // Pixels of one captured frame, only valid during the callback they are passed to.
+    struct LveReadbackFrame
+    {
+        // Graphics timeline value of the frame, see LveRenderer::getFrameNumber().
+        uint64_t frameNumber{0};
+        VkExtent2D extent{};
+        // Tightly packed rows of texels in colorFormat, LveFrameReadback::texelSize() bytes each.
+        VkFormat colorFormat{VK_FORMAT_UNDEFINED};
+        const void *color{nullptr};
+        // Depth aspect only, packed the same way. Null unless the capture asked for it.
+        VkFormat depthFormat{VK_FORMAT_UNDEFINED};
+        const void *depth{nullptr};
+    };
+
+    // Copies rendered frames back to the CPU without stalling. capture() records the copy into a
+    // ring of host visible buffers at the end of the frame's command buffer, and update() hands the
+    // data to the callback once the frame has completed on the graphics timeline. When every
+    // buffer is still waiting for its frame, captures are dropped rather than waited for.
+    // Captures still pending when it is destroyed are dropped.
+    class LveFrameReadback
+    {
+    public:
+        using Callback = std::function<void(const LveReadbackFrame &frame)>;
+
+        // slotCount captures may be pending at once, one more than the frames in flight keeps
+        // capturing every frame.
+        LveFrameReadback(LveDevice &device, LveRenderer &renderer, uint32_t slotCount = 4);
+
+        LveFrameReadback(const LveFrameReadback &) = delete;
+        LveFrameReadback &operator=(const LveFrameReadback &) = delete;
+
+        // Call after endSwapChainRenderPass, with the images left in the render pass's final
+        // layouts. withDepth needs LveFrameSettings::readableDepth. Returns false and records
+        // nothing when no buffer is free, throws when a format has no known texel size.
+        bool capture(VkCommandBuffer commandBuffer, Callback callback, bool withDepth = false);
+        // Delivers completed captures in the order they were made, never waits. Call once per frame.
+        void update();
+        // Waits for every pending capture and delivers it.
+        void flush();
+
+        uint64_t getDroppedCount() const { return droppedCount; }
+
+        // Bytes per texel of a color format as copied to a buffer, of the depth aspect alone for
+        // depth formats. 0 for formats that cannot be read back.
+        static uint32_t texelSize(VkFormat format);
+
+    private:
+        struct Slot
+        {
+            std::unique_ptr<LveBuffer> colorBuffer{};
+            std::unique_ptr<LveBuffer> depthBuffer{};
+            LveReadbackFrame frame{};
+            Callback callback{};
+        };
+
+        // Replaces the slot's buffers when their size no longer matches the frame, or depth is
+        // needed for the first time.
+        void prepareSlot(Slot &slot, VkExtent2D extent);
+        void deliver(Slot &slot);
+
+        LveDevice &lveDevice;
+        LveRenderer &lveRenderer;
+        // Pending captures are the pendingCount slots from oldestSlot on, wrapping around.
+        std::vector<Slot> slots;
+        uint32_t oldestSlot{0};
+        uint32_t pendingCount{0};
+        uint64_t droppedCount{0};
+    };
+}
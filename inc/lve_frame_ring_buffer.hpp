@@ -0,0 +1,59 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_buffer.hpp"
+
+#include <memory>
+
+namespace lve
+{
+    // Space handed out by LveFrameRingBuffer, valid until the same frame slot comes around again.
+    struct LveFrameAllocation
+    {
+        void *data{nullptr};
+        // Offset into the ring buffer, passed as the dynamic offset when binding.
+        uint32_t dynamicOffset{0};
+    };
+
+    // Linear allocator for per-frame uniform and storage data on one persistently mapped buffer,
+    // split into a region per frame in flight. Descriptors are written once over the whole buffer
+    // with *_DYNAMIC types and each draw selects its data through the dynamic offset, so per-pass
+    // and per-view data needs no buffers or descriptor sets of its own.
+    //
+    // Allocations are aligned to the device's uniform, storage and non-coherent atom alignments,
+    // so endFrame() can flush exactly the written part of the region.
+    class LveFrameRingBuffer
+    {
+    public:
+        LveFrameRingBuffer(
+            LveDevice &device,
+            VkDeviceSize capacityPerFrame,
+            uint32_t frameCount,
+            VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+        LveFrameRingBuffer(const LveFrameRingBuffer &) = delete;
+        LveFrameRingBuffer &operator=(const LveFrameRingBuffer &) = delete;
+
+        // The frame's previous contents must no longer be read by the GPU, which holds once the
+        // renderer has begun the frame, as acquiring waits for the slot's previous frame.
+        void beginFrame(uint32_t frameIndex);
+        LveFrameAllocation allocate(VkDeviceSize size);
+        LveFrameAllocation write(const void *data, VkDeviceSize size);
+        // Flushes what was allocated since beginFrame().
+        void endFrame();
+
+        // Descriptor for *_DYNAMIC bindings, range is the size of the data one draw reads.
+        VkDescriptorBufferInfo descriptorInfo(VkDeviceSize range) { return buffer->descriptorInfo(range, 0); }
+        VkDeviceSize getAlignment() const { return alignment; }
+
+    private:
+        VkDeviceSize frameCapacity;
+        uint32_t frameCount;
+        VkDeviceSize alignment{1};
+        std::unique_ptr<LveBuffer> buffer;
+
+        VkDeviceSize frameStart{0};
+        VkDeviceSize cursor{0};
+        bool frameStarted{false};
+    };
+}
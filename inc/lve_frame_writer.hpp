@@ -0,0 +1,72 @@
+#pragma once
+
+#include "lve_frame_readback.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lve
+{
+    enum class LveFrameFileFormat
+    {
+        // 8 bit RGB, needs an 8 bit RGBA or BGRA color format.
+        Png,
+        // The texels as read back, without a header.
+        Raw,
+    };
+
+    // Writes captured frames to frame_<number> files in a directory on a background thread, so
+    // encoding and disk access stay off the render loop. Depth, when captured, always goes to a
+    // raw frame_<number>_depth file. At most maxQueued frames wait to be written, past that write()
+    // blocks until the disk catches up.
+    class LveFrameWriter
+    {
+    public:
+        LveFrameWriter(
+            const std::string &directory, LveFrameFileFormat format = LveFrameFileFormat::Png, uint32_t maxQueued = 8);
+        // Writes every queued frame before returning.
+        ~LveFrameWriter();
+
+        LveFrameWriter(const LveFrameWriter &) = delete;
+        LveFrameWriter &operator=(const LveFrameWriter &) = delete;
+
+        // Copies the frame, so it may be called from a readback callback. An error from writing an
+        // earlier frame is rethrown here.
+        void write(const LveReadbackFrame &frame);
+
+        uint64_t getWrittenCount();
+
+    private:
+        struct Job
+        {
+            uint64_t frameNumber{0};
+            VkExtent2D extent{};
+            VkFormat colorFormat{VK_FORMAT_UNDEFINED};
+            std::vector<uint8_t> color{};
+            std::vector<uint8_t> depth{};
+        };
+
+        void workerLoop();
+        void writeJob(const Job &job);
+
+        std::string directory;
+        LveFrameFileFormat format;
+        uint32_t maxQueued;
+
+        std::mutex mutex{};
+        std::condition_variable jobCondition{};
+        std::condition_variable spaceCondition{};
+        std::deque<Job> jobs{};
+        std::exception_ptr error{};
+        uint64_t writtenCount{0};
+        bool stopping{false};
+        // Last, so it starts once everything it uses is initialized.
+        std::thread worker;
+    };
+}
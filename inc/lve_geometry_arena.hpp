@@ -0,0 +1,81 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_buffer.hpp"
+#include "lve_tlsf_allocator.hpp"
+#include "lve_upload_batcher.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace lve
+{
+    // Range of a geometry arena block holding one model's vertices or indices.
+    struct LveGeometryAllocation
+    {
+        uint32_t block{LveTlsfAllocator::INVALID_NODE};
+        uint32_t node{LveTlsfAllocator::INVALID_NODE};
+        // In bytes from the start of the block's buffer.
+        VkDeviceSize offset{0};
+        // Completes when the data has landed in the block.
+        LveUploadHandle upload{};
+
+        bool isValid() const { return block != LveTlsfAllocator::INVALID_NODE; }
+    };
+
+    // Packs the geometry of all models into a few large device local buffers so they are bound once
+    // and drawn with firstIndex / vertexOffset, instead of one allocation and bind per model.
+    //
+    // Vertex blocks are sub-allocated in whole vertices of one stride, so an offset is always a
+    // valid vertexOffset. Index blocks are shared by 16 and 32 bit indices and sub-allocated in
+    // 4 byte units, which keeps every range aligned for either index type. A new block is only
+    // created when no existing one has room, empty ones are only released by trim(). Data goes
+    // through the upload batcher, so it is only on the GPU once the batcher is flushed.
+    class LveGeometryArena
+    {
+    public:
+        static constexpr VkDeviceSize VERTEX_BLOCK_SIZE{32 * 1024 * 1024};
+        static constexpr VkDeviceSize INDEX_BLOCK_SIZE{16 * 1024 * 1024};
+        static constexpr VkDeviceSize INDEX_UNIT_SIZE{4};
+
+        LveGeometryArena(LveDevice &device, LveUploadBatcher &uploadBatcher);
+        ~LveGeometryArena();
+
+        LveGeometryArena(const LveGeometryArena &) = delete;
+        LveGeometryArena &operator=(const LveGeometryArena &) = delete;
+
+        // Allocates count elements and queues the upload of data.
+        LveGeometryAllocation allocateVertices(const void *data, uint32_t vertexSize, uint32_t count);
+        LveGeometryAllocation allocateIndices(const void *data, uint32_t indexSize, uint32_t count);
+        // The range must no longer be in use by the GPU.
+        void free(LveGeometryAllocation &allocation);
+        // Copies size bytes of the range back to the CPU. Waits for the range's upload and for the
+        // queue to go idle, so it is meant for rare operations such as eviction.
+        void readBack(const LveGeometryAllocation &allocation, void *data, VkDeviceSize size);
+        // Releases blocks with no allocations left.
+        void trim();
+
+        VkBuffer getBuffer(const LveGeometryAllocation &allocation) const;
+        LveDevice &getDevice() { return lveDevice; }
+        // Device memory held by blocks, and the part of it taken by allocations.
+        VkDeviceSize getReservedSize() const;
+        VkDeviceSize getUsedSize() const;
+
+    private:
+        // A null buffer marks a slot released by trim(), reused by the next new block.
+        struct Block
+        {
+            std::unique_ptr<LveBuffer> buffer;
+            LveTlsfAllocator allocator;
+            VkBufferUsageFlags usage;
+            VkDeviceSize unitSize;
+        };
+
+        LveGeometryAllocation allocate(
+            const void *data, VkDeviceSize size, VkBufferUsageFlags usage, VkDeviceSize unitSize, VkDeviceSize blockSize);
+
+        LveDevice &lveDevice;
+        LveUploadBatcher &uploadBatcher;
+        std::vector<Block> blocks{};
+    };
+}
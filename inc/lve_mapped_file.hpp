@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace lve
+{
+    // Read-only memory mapping of a whole file. The mapping lives as long as the object.
+    class LveMappedFile
+    {
+    public:
+        LveMappedFile(const std::string &filePath);
+        ~LveMappedFile();
+
+        LveMappedFile(const LveMappedFile &) = delete;
+        LveMappedFile &operator=(const LveMappedFile &) = delete;
+
+        const char *data() const { return mapped; }
+        size_t size() const { return fileSize; }
+
+    private:
+        const char *mapped{nullptr};
+        size_t fileSize{0};
+
+#ifdef _WIN32
+        void *fileHandle{nullptr};
+        void *mappingHandle{nullptr};
+#else
+        int fileDescriptor{-1};
+#endif
+    };
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "lve_tlsf_allocator.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <mutex>
+#include <vector>
+
+namespace lve
+{
+    // What an allocation backs, only used for accounting.
+    enum class LveMemoryCategory : uint32_t
+    {
+        Geometry,
+        // Uniform and storage buffers.
+        Uniform,
+        Staging,
+        Image,
+        Other,
+        Count,
+    };
+
+    // Device memory range backing one buffer or image. mapped points at offset when the memory
+    // type is host visible, since such memory stays mapped for its whole lifetime.
+    struct LveAllocation
+    {
+        VkDeviceMemory memory{VK_NULL_HANDLE};
+        VkDeviceSize offset{0};
+        VkDeviceSize size{0};
+        void *mapped{nullptr};
+        // Of the memory type actually chosen, which may have more flags than requested.
+        VkMemoryPropertyFlags propertyFlags{0};
+        uint32_t memoryTypeIndex{0};
+        LveMemoryCategory category{LveMemoryCategory::Other};
+
+        // Owning block, INVALID_NODE for dedicated allocations.
+        uint32_t block{LveTlsfAllocator::INVALID_NODE};
+        uint32_t node{LveTlsfAllocator::INVALID_NODE};
+    };
+
+    struct LveMemoryStats
+    {
+        uint32_t blockCount{0};
+        uint32_t dedicatedCount{0};
+        uint32_t allocationCount{0};
+        // Memory taken from the driver, and the part of it handed out to resources.
+        VkDeviceSize reservedBytes{0};
+        VkDeviceSize usedBytes{0};
+        // Used bytes per LveMemoryCategory.
+        std::array<VkDeviceSize, static_cast<size_t>(LveMemoryCategory::Count)> categoryBytes{};
+    };
+
+    struct LveHeapBudget
+    {
+        VkDeviceSize size{0};
+        // How much this process may use and does use, as reported by VK_EXT_memory_budget. Without
+        // the extension the budget is a fixed share of the heap and usage only counts this allocator.
+        VkDeviceSize budget{0};
+        VkDeviceSize usage{0};
+        bool deviceLocal{false};
+    };
+
+    // Sub-allocates resources from large per memory type blocks so the driver sees a handful of
+    // vkAllocateMemory calls instead of one per resource.
+    //
+    // Buffers and optimal tiling images never share a block, which keeps them from landing within
+    // bufferImageGranularity of each other without tracking neighbours. Resources larger than half
+    // a block get a dedicated allocation. Empty blocks are released, except the last one of each
+    // kind so a create / destroy cycle does not hit the driver every time.
+    class LveMemoryAllocator
+    {
+    public:
+        static constexpr VkDeviceSize BLOCK_SIZE{64 * 1024 * 1024};
+        // Share of a heap assumed available when the driver cannot report a budget.
+        static constexpr float FALLBACK_BUDGET_FRACTION{0.8f};
+
+        // getMemoryProperties2 is only passed when VK_EXT_memory_budget is enabled.
+        LveMemoryAllocator(
+            VkPhysicalDevice physicalDevice,
+            VkDevice device,
+            PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr);
+        ~LveMemoryAllocator();
+
+        LveMemoryAllocator(const LveMemoryAllocator &) = delete;
+        LveMemoryAllocator &operator=(const LveMemoryAllocator &) = delete;
+
+        // linear is true for buffers and linear tiling images.
+        LveAllocation allocate(
+            const VkMemoryRequirements &requirements,
+            uint32_t memoryTypeIndex,
+            bool linear,
+            LveMemoryCategory category = LveMemoryCategory::Other);
+        void free(LveAllocation &allocation);
+
+        // Range for vkFlushMappedMemoryRanges / vkInvalidateMappedMemoryRanges, relative to the
+        // allocation and widened to nonCoherentAtomSize.
+        VkMappedMemoryRange mappedRange(
+            const LveAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) const;
+
+        LveMemoryStats getStats();
+        // Indexed by heap.
+        std::vector<LveHeapBudget> getHeapBudgets();
+        bool hasDriverBudget() const { return getMemoryProperties2 != nullptr; }
+
+    private:
+        struct Block
+        {
+            VkDeviceMemory memory{VK_NULL_HANDLE};
+            VkDeviceSize size{0};
+            void *mapped{nullptr};
+            LveTlsfAllocator allocator{0};
+            uint32_t memoryTypeIndex{0};
+            bool linear{false};
+            uint32_t allocationCount{0};
+        };
+
+        bool allocateMemory(uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory &memory, void *&mapped);
+        void freeMemory(uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory memory, void *mapped);
+        VkDeviceSize preferredBlockSize(uint32_t memoryTypeIndex) const;
+
+        VkPhysicalDevice physicalDevice;
+        VkDevice device;
+        PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2;
+        VkPhysicalDeviceMemoryProperties memoryProperties{};
+        VkDeviceSize nonCoherentAtomSize{1};
+
+        std::mutex mutex{};
+        std::vector<Block> blocks{};
+        std::vector<uint32_t> unusedBlocks{};
+        uint32_t dedicatedCount{0};
+        VkDeviceSize dedicatedBytes{0};
+        std::array<VkDeviceSize, static_cast<size_t>(LveMemoryCategory::Count)> categoryBytes{};
+        // Memory taken from the driver per heap, blocks and dedicated allocations alike.
+        std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> heapBytes{};
+    };
+}
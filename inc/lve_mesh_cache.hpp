@@ -0,0 +1,30 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+#include <string>
+
+namespace lve
+{
+    // Versioned binary sidecar (<model>.lvemesh) holding the deduplicated vertex, index, meshlet
+    // and detail level blobs produced by LveModel::Builder, so warm starts skip OBJ parsing entirely.
+    //
+    // Layout: header | vertex blob | index blob | meshlet blob | lod blob, blobs 16 byte aligned. The header records the
+    // size and write time of the source file; a mismatch marks the sidecar as stale. Flags record
+    // the load options the blobs were produced with, a sidecar written with other options is stale.
+    class LveMeshCache
+    {
+    public:
+        static constexpr uint32_t MAGIC{0x4D45564C}; // "LVEM"
+        static constexpr uint32_t VERSION{4};
+
+        static constexpr uint32_t FLAG_OPTIMIZED{1u << 0};
+
+        static std::string cachePath(const std::string &sourcePath);
+
+        // Returns false if the sidecar is missing, stale or malformed.
+        static bool load(const std::string &sourcePath, uint32_t flags, LveModel::Builder &builder);
+        // Returns false if the sidecar could not be written.
+        static bool store(const std::string &sourcePath, uint32_t flags, const LveModel::Builder &builder);
+    };
+}
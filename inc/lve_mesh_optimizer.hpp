@@ -0,0 +1,45 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+#include <vector>
+
+namespace lve
+{
+    // Post-transform vertex cache efficiency of an index buffer, measured with a simulated FIFO
+    // cache. ACMR is misses per triangle (3 is the worst case, ~0.5 the best for regular meshes),
+    // ATVR is misses per referenced vertex (1 is optimal).
+    struct LveVertexCacheStats
+    {
+        float acmr{0.f};
+        float atvr{0.f};
+    };
+
+    // CPU only reordering passes for LveModel::Builder output, meant to run before upload:
+    //  1. optimizeVertexCache reorders triangles with Tipsify for post-transform cache hits.
+    //  2. optimizeOverdraw splits that order into clusters and draws outward facing ones first.
+    //  3. optimizeVertexFetch renumbers vertices in first-use order of the index buffer.
+    class LveMeshOptimizer
+    {
+    public:
+        static constexpr uint32_t CACHE_SIZE{16};
+        // Clusters may be this much worse than the Tipsify order in ACMR to reduce overdraw.
+        static constexpr float OVERDRAW_THRESHOLD{1.05f};
+
+        static LveVertexCacheStats analyzeVertexCache(
+            const std::vector<uint32_t> &indices, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+
+        static void optimizeVertexCache(
+            std::vector<uint32_t> &indices, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+        static void optimizeOverdraw(
+            std::vector<uint32_t> &indices,
+            const std::vector<LveModel::Vertex> &vertices,
+            float threshold = OVERDRAW_THRESHOLD,
+            uint32_t cacheSize = CACHE_SIZE);
+        static void optimizeVertexFetch(
+            std::vector<LveModel::Vertex> &vertices, std::vector<uint32_t> &indices);
+
+        // Runs the three passes in order.
+        static void optimize(LveModel::Builder &builder);
+    };
+}
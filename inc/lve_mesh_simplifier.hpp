@@ -0,0 +1,36 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+#include <vector>
+
+namespace lve
+{
+    // Quadric error metric simplification (Garland & Heckbert 1997) by half-edge collapses.
+    //
+    // Vertices sharing a position are collapsed together, each attribute vertex moving to the
+    // vertex of the target position it shares a triangle with. Attribute changes are added to the
+    // cost, weighted against the position error. Positions on open borders are locked so
+    // silhouettes of open meshes stay in place, and collapses that flip a triangle are rejected.
+    class LveMeshSimplifier
+    {
+    public:
+        // Relative triangle counts of the generated detail levels after the full one.
+        static constexpr float LOD_TARGETS[]{0.5f, 0.25f, 0.1f};
+        // Attribute distance counted as this fraction of the mesh extent in position error.
+        static constexpr float ATTRIBUTE_WEIGHT{0.02f};
+
+        // Returns at most targetIndexCount indices over the same vertex array, fewer collapses
+        // are done when no valid one is left. error receives the largest collapse error, in the
+        // same units as the vertex positions.
+        static std::vector<uint32_t> simplify(
+            const std::vector<LveModel::Vertex> &vertices,
+            const std::vector<uint32_t> &indices,
+            size_t targetIndexCount,
+            float &error);
+
+        // Appends simplified detail levels for LOD_TARGETS to builder.indices and records them in
+        // builder.lods. Levels that no longer reduce the triangle count are skipped.
+        static void generateLods(LveModel::Builder &builder);
+    };
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace lve
+{
+    // A run of at most MAX_TRIANGLES consecutive triangles referencing at most MAX_VERTICES
+    // vertices in a model's index buffer, with model space bounds for rejecting it before the draw.
+    //
+    // The normal cone follows meshoptimizer: the cluster faces away from a viewer at p when
+    // dot(normalize(coneApex - p), coneAxis) >= coneCutoff. A cutoff of 1 disables the test.
+    struct LveMeshlet
+    {
+        static constexpr uint32_t MAX_VERTICES{64};
+        static constexpr uint32_t MAX_TRIANGLES{124};
+
+        uint32_t firstIndex{0};
+        uint32_t indexCount{0};
+        glm::vec3 center{};
+        float radius{0.f};
+        glm::vec3 coneApex{};
+        float coneCutoff{1.f};
+        glm::vec3 coneAxis{};
+    };
+
+    // Per draw visibility test for meshlets, done in model space so the meshlet bounds are used
+    // as stored. Cone culling is opt-in because it is only valid when back faces are not drawn.
+    class LveMeshletCuller
+    {
+    public:
+        LveMeshletCuller(
+            const glm::mat4 &projectionView,
+            const glm::mat4 &modelMatrix,
+            const glm::vec3 &worldCameraPosition,
+            bool coneCulling = false);
+
+        bool isVisible(const LveMeshlet &meshlet) const;
+
+    private:
+        glm::vec4 frustumPlanes[6];
+        glm::vec3 cameraPosition{};
+        bool coneCulling;
+    };
+}
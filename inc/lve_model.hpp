@@ -5,16 +5,26 @@
 #include <glm/glm.hpp>
 
 #include "lve_device.hpp"
-#include "lve_buffer.hpp"
+#include "lve_geometry_arena.hpp"
+#include "lve_meshlet.hpp"
 
 #include <memory>
 #include <vector>
 
 namespace lve
 {
+    class LveResidencyManager;
+    struct LveVertexCacheStats;
+
     class LveModel
     {
     public:
+        enum class VertexFormat
+        {
+            Float,
+            Compact,
+        };
+
         struct Vertex
         {
             glm::vec3 position{};
@@ -34,37 +44,155 @@ namespace lve
             }
         };
 
+        // 20 byte quantized vertex: position as UNORM16 within the mesh bounds (decoded by
+        // getPositionDecode()), octahedral SNORM16 normal, UNORM8 color and half float uv.
+        struct CompactVertex
+        {
+            uint16_t position[4]{};
+            int16_t normal[2]{};
+            uint8_t color[4]{};
+            uint16_t uv[2]{};
+
+            static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+            static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+        };
+
+        // Index range drawn with its own base vertex. Meshes too large for 16 bit indices are split
+        // into several of these so each one still fits.
+        struct Submesh
+        {
+            uint32_t firstIndex{0};
+            uint32_t indexCount{0};
+            int32_t vertexOffset{0};
+        };
+
+        // Detail level as an index range over the shared vertex buffer, with the meshlets covering
+        // it. error is the largest surface deviation from the full mesh, in model units.
+        struct Lod
+        {
+            uint32_t firstIndex{0};
+            uint32_t indexCount{0};
+            uint32_t firstMeshlet{0};
+            uint32_t meshletCount{0};
+            float error{0.f};
+        };
+
+        // Geometry buffers last bound to a command buffer, so models sharing arena blocks skip
+        // redundant binds. Start each command buffer with a default constructed one.
+        struct BindState
+        {
+            VkBuffer vertexBuffer{VK_NULL_HANDLE};
+            VkBuffer indexBuffer{VK_NULL_HANDLE};
+            VkIndexType indexType{VK_INDEX_TYPE_MAX_ENUM};
+        };
+
         struct Builder
         {
             std::vector<Vertex> vertices{};
             std::vector<uint32_t> indices{};
+            glm::vec3 boundsMin{};
+            glm::vec3 boundsMax{};
+            std::vector<LveMeshlet> meshlets{};
+            // Empty means the whole index buffer is a single level.
+            std::vector<Lod> lods{};
 
             void loadModel(const std::string &filePath);
+            // Takes the mesh cache sidecar when it is current, otherwise parses the file, optimizes
+            // it and generates detail levels when asked to, builds the meshlets and writes the
+            // sidecar. Returns whether the sidecar was used. The vertex cache figures of the full
+            // detail level are written to before and after when given: as parsed and as optimized
+            // on a cold load, only after, as stored, on a warm one.
+            bool loadCached(
+                const std::string &filePath,
+                bool optimize,
+                LveVertexCacheStats *before = nullptr,
+                LveVertexCacheStats *after = nullptr);
+            void computeBounds();
+            // Splits every detail level into meshlets, filling in the meshlet ranges of lods.
+            void buildMeshlets();
+            void buildMeshlets(uint32_t firstIndex, uint32_t lastIndex);
         };
 
-        LveModel(LveDevice &lveDevice, const Builder &builder);
+        LveModel(
+            LveGeometryArena &geometryArena, const Builder &builder, VertexFormat vertexFormat = VertexFormat::Float);
         ~LveModel();
 
+        // With optimize set, the mesh is reordered by LveMeshOptimizer before upload and
+        // simplified detail levels are generated by LveMeshSimplifier.
         static std::unique_ptr<LveModel> createModelFromFile(
-            LveDevice &device, const std::string &filePath);
+            LveGeometryArena &geometryArena,
+            const std::string &filePath,
+            bool optimize = true,
+            VertexFormat vertexFormat = VertexFormat::Float);
 
         LveModel(const LveModel &) = delete;
         LveModel &operator=(const LveModel &) = delete;
 
+        // Marks the model as drawn when it is tracked by a residency manager, which must have made
+        // it resident.
         void bind(VkCommandBuffer commandBuffer);
+        // Only binds the buffers that differ from state, then updates it.
+        void bind(VkCommandBuffer commandBuffer, BindState &state);
+        // Draws the full detail level.
         void draw(VkCommandBuffer commandBuffer);
+        // Draws only the meshlets of the given level the culler accepts, merging runs of adjacent
+        // ones into a single draw. Models without meshlets draw the whole level. Returns the
+        // meshlets drawn.
+        uint32_t drawVisible(VkCommandBuffer commandBuffer, const LveMeshletCuller &culler, uint32_t lod = 0);
+
+        VertexFormat getVertexFormat() const { return vertexFormat; }
+        // Maps the stored positions back to model space, identity for the float format.
+        const glm::mat4 &getPositionDecode() const { return positionDecode; }
+        VkIndexType getIndexType() const { return indexType; }
+        // Ordered from full detail to coarsest, never empty.
+        const std::vector<Lod> &getLods() const { return lods; }
+        // Model space bounding sphere.
+        const glm::vec3 &getBoundsCenter() const { return boundsCenter; }
+        float getBoundsRadius() const { return boundsRadius; }
+
+        // Geometry residency, driven by LveResidencyManager.
+        bool isResident() const { return vertexAllocation.isValid(); }
+        // Bytes of vertex and index data on the GPU while resident.
+        VkDeviceSize getGeometrySize() const;
+        // Reads the geometry back into data and releases its arena ranges. The model must not be
+        // in use by the GPU.
+        void evictGeometry(std::vector<char> &data);
+        // Uploads data produced by evictGeometry() again.
+        void restoreGeometry(const std::vector<char> &data);
+        void setResidencyManager(LveResidencyManager *manager) { residencyManager = manager; }
 
     private:
-        void createVertexBuffers(const std::vector<Vertex> &vertices);
-        void createIndexBuffers(const std::vector<uint32_t> &indices);
-
-        LveDevice &lveDevice;
-
-        std::unique_ptr<LveBuffer> vertexBuffer;
+        bool narrowIndices(
+            const Builder &builder,
+            std::vector<Vertex> &splitVertices,
+            std::vector<uint16_t> &shortIndices);
+        std::vector<CompactVertex> compressVertices(
+            const std::vector<Vertex> &vertices, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax);
+        void createVertexBuffers(const void *vertexData, uint32_t vertexSize, uint32_t count);
+        void createIndexBuffers(const void *indexData, uint32_t indexSize, uint32_t count);
+        void drawIndexRange(VkCommandBuffer commandBuffer, uint32_t firstIndex, uint32_t count);
+
+        LveGeometryArena &geometryArena;
+        LveResidencyManager *residencyManager{nullptr};
+
+        VertexFormat vertexFormat;
+        glm::mat4 positionDecode{1.f};
+
+        LveGeometryAllocation vertexAllocation{};
+        int32_t baseVertex{0};
         uint32_t vertexCount;
+        uint32_t vertexSize;
 
         bool hasIndexBuffer{false};
-        std::unique_ptr<LveBuffer> indexBuffer;
+        LveGeometryAllocation indexAllocation{};
+        uint32_t baseIndex{0};
         uint32_t indexCount;
+        uint32_t indexSize{0};
+        VkIndexType indexType{VK_INDEX_TYPE_UINT32};
+        std::vector<Submesh> submeshes{};
+        std::vector<LveMeshlet> meshlets{};
+        std::vector<Lod> lods{};
+        glm::vec3 boundsCenter{};
+        float boundsRadius{0.f};
     };
 }
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+#include <string>
+#include <vector>
+
+namespace lve
+{
+    // Single pass Wavefront OBJ parser working on a memory-mapped file. Faces are resolved into
+    // LveModel::Vertex corners as they are read, so only the raw v/vt/vn pools are kept around.
+    // Supports v (with optional rgb), vt, vn and f (v, v/vt, v//vn, v/vt/vn, negative indices);
+    // polygons are fan triangulated and every other statement is ignored.
+    class LveObjParser
+    {
+    public:
+        LveObjParser(const std::string &filePath);
+
+        LveObjParser(const LveObjParser &) = delete;
+        LveObjParser &operator=(const LveObjParser &) = delete;
+
+        void parse(std::vector<LveModel::Vertex> &vertices, std::vector<uint32_t> &indices);
+
+    private:
+        void parseVertex(const char *p, const char *end);
+        void parseTexcoord(const char *p, const char *end);
+        void parseNormal(const char *p, const char *end);
+        void parseFace(const char *p, const char *end);
+
+        uint32_t resolveIndex(int index, size_t count, const char *kind) const;
+        [[noreturn]] void fail(const std::string &reason) const;
+
+        std::string filePath;
+        size_t lineNumber{0};
+
+        std::vector<glm::vec3> positions{};
+        std::vector<glm::vec3> colors{};
+        std::vector<glm::vec3> normals{};
+        std::vector<glm::vec2> texcoords{};
+        std::vector<LveModel::Vertex> faceVertices{};
+        std::vector<uint32_t> faceCorners{};
+    };
+}
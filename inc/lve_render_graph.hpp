@@ -0,0 +1,102 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_render_graph_plan.hpp"
+#include "lve_renderer.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace lve
+{
+    // Frame built from passes that declare the images they read and write, recorded over the
+    // renderer's frame command buffer. compile() works out, through LveRenderGraphPlan, everything
+    // per-frame recording would otherwise be hand tuned for:
+    //
+    //  - passes contributing nothing to the backbuffer, or to a pass with side effects, are culled
+    //  - each pass gets one pipeline barrier holding every layout transition and dependency it
+    //    needs, and none when the previous access already covers it
+    //  - attachments clear on their first write of the frame and load afterwards, and are only
+    //    stored when a later pass uses them
+    //  - transient images whose lifetimes do not overlap share memory
+    //
+    // Passes run in the order they were added, so a pass may only read what earlier passes wrote.
+    // The pass writing getBackbuffer() renders through the renderer's swap chain render pass, with
+    // the swap chain depth image, so pipelines built for getSwapChainRenderPass() work there. It
+    // must be the last pass and may write no other attachments.
+    class LveRenderGraph
+    {
+    public:
+        static constexpr LveRenderGraphResource INVALID_RESOURCE{LveRenderGraphPlan::INVALID_RESOURCE};
+
+        using PassBuilder = LveRenderGraphPlan::PassBuilder;
+
+        LveRenderGraph(LveDevice &device, LveRenderer &renderer);
+        ~LveRenderGraph();
+
+        LveRenderGraph(const LveRenderGraph &) = delete;
+        LveRenderGraph &operator=(const LveRenderGraph &) = delete;
+
+        // Only lives within a frame, its contents are undefined when the frame begins.
+        LveRenderGraphResource createImage(const std::string &name, const LveRenderGraphImageInfo &info);
+        LveRenderGraphResource getBackbuffer() const { return plan.getBackbuffer(); }
+        void addPass(
+            const std::string &name,
+            const std::function<void(PassBuilder &builder)> &setup,
+            std::function<void(VkCommandBuffer commandBuffer)> execute);
+        // Switches the backbuffer pass between inline and secondary command buffer recording,
+        // from the next execute() on and without recompiling.
+        void setBackbufferContents(VkSubpassContents contents);
+
+        // Creates the images, render passes and framebuffers. The previous ones are released once
+        // frames in flight are done with them. Called by execute() when the swap chain extent
+        // changed, descriptors of images read by passes must be written again then.
+        void compile();
+        // Records the passes that survived culling, viewport and scissor are set for inline passes.
+        void execute(VkCommandBuffer commandBuffer);
+
+        // For creating pipelines, valid until the next compile.
+        VkRenderPass getRenderPass(const std::string &passName) const;
+        VkImageView getImageView(LveRenderGraphResource image) const;
+        // Increases with every compile.
+        uint32_t getVersion() const { return version; }
+        const LveRenderGraphStats &getStats() const { return plan.getStats(); }
+
+    private:
+        // Vulkan objects of an image, null for the backbuffer and images no surviving pass uses.
+        struct ImageResources
+        {
+            VkImage image{VK_NULL_HANDLE};
+            VkImageView view{VK_NULL_HANDLE};
+        };
+
+        struct PassResources
+        {
+            std::function<void(VkCommandBuffer)> execute;
+            VkRenderPass renderPass{VK_NULL_HANDLE};
+            VkFramebuffer framebuffer{VK_NULL_HANDLE};
+            // The plan's barriers with the image handles filled in.
+            std::vector<VkImageMemoryBarrier> barriers{};
+        };
+
+        // Creates the image once the plan knows its extent and usage.
+        VkMemoryRequirements createTransientImage(LveRenderGraphResource index);
+        void bindImages();
+        void createRenderPasses();
+        // Hands everything compiled to the deletion queue.
+        void releaseCompiled();
+
+        LveDevice &lveDevice;
+        LveRenderer &lveRenderer;
+
+        LveRenderGraphPlan plan{};
+        std::vector<ImageResources> imageResources{};
+        std::vector<PassResources> passResources{};
+        std::vector<LveAllocation> slotAllocations{};
+
+        bool compiled{false};
+        VkExtent2D compiledExtent{};
+        uint32_t version{0};
+    };
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace lve
+{
+    using LveRenderGraphResource = uint32_t;
+
+    struct LveRenderGraphImageInfo
+    {
+        VkFormat format{VK_FORMAT_UNDEFINED};
+        // 0 follows the swap chain extent, and the images are recreated when it changes.
+        VkExtent2D extent{0, 0};
+    };
+
+    struct LveRenderGraphStats
+    {
+        uint32_t passCount{0};
+        uint32_t culledPassCount{0};
+        uint32_t barrierBatchCount{0};
+        uint32_t imageBarrierCount{0};
+        uint32_t transientImageCount{0};
+        // Allocations shared by transient images whose lifetimes do not overlap.
+        uint32_t memorySlotCount{0};
+        // Memory the transient images would take on their own, and what the slots take.
+        VkDeviceSize transientBytes{0};
+        VkDeviceSize allocatedBytes{0};
+    };
+
+    // The passes and images of an LveRenderGraph and every decision compiling them takes: culling,
+    // image lifetimes and memory slots, load and store ops, and barriers. It makes no Vulkan calls,
+    // LveRenderGraph creates the objects it describes, so it can be checked without a device.
+    class LveRenderGraphPlan
+    {
+    public:
+        static constexpr LveRenderGraphResource INVALID_RESOURCE{std::numeric_limits<uint32_t>::max()};
+        static constexpr uint32_t NO_PASS{std::numeric_limits<uint32_t>::max()};
+
+        class PassBuilder
+        {
+        public:
+            // Attachments are numbered in the order they are added, depth last.
+            PassBuilder &writeColor(
+                LveRenderGraphResource image, VkClearColorValue clearValue = {{0.01f, 0.01f, 0.01f, 1.0f}});
+            PassBuilder &writeDepth(LveRenderGraphResource image, VkClearDepthStencilValue clearValue = {1.0f, 0});
+            // Sampled by fragment shaders.
+            PassBuilder &read(LveRenderGraphResource image);
+            // Keeps the pass even when nothing depends on its output.
+            PassBuilder &setSideEffects();
+            // Only for the backbuffer pass, see LveRenderer::beginSwapChainRenderPass.
+            PassBuilder &setContents(VkSubpassContents contents);
+
+        private:
+            friend class LveRenderGraphPlan;
+            PassBuilder(LveRenderGraphPlan &plan, uint32_t pass) : plan{plan}, pass{pass} {}
+
+            LveRenderGraphPlan &plan;
+            uint32_t pass;
+        };
+
+        struct Image
+        {
+            std::string name;
+            LveRenderGraphImageInfo info;
+
+            // Compiled, firstPass is NO_PASS for the backbuffer and images no surviving pass uses.
+            VkExtent2D extent{};
+            VkImageUsageFlags usage{0};
+            uint32_t firstPass{NO_PASS};
+            uint32_t lastPass{NO_PASS};
+            uint32_t slot{0};
+            VkMemoryRequirements requirements{};
+        };
+
+        struct Pass
+        {
+            std::string name;
+            std::vector<LveRenderGraphResource> colorWrites{};
+            std::vector<VkClearColorValue> colorClearValues{};
+            LveRenderGraphResource depthWrite{INVALID_RESOURCE};
+            VkClearDepthStencilValue depthClearValue{};
+            std::vector<LveRenderGraphResource> reads{};
+            bool sideEffects{false};
+            VkSubpassContents contents{VK_SUBPASS_CONTENTS_INLINE};
+
+            // Compiled. The attachment vectors follow the attachment numbering, and are empty for
+            // the backbuffer pass, which uses the swap chain render pass.
+            bool culled{false};
+            VkExtent2D extent{};
+            std::vector<VkAttachmentLoadOp> loadOps{};
+            std::vector<VkAttachmentStoreOp> storeOps{};
+            std::vector<VkClearValue> clearValues{};
+            // Their image handles are left null, barrierImages holds the image each one is for.
+            std::vector<VkImageMemoryBarrier> barriers{};
+            std::vector<LveRenderGraphResource> barrierImages{};
+            VkPipelineStageFlags srcStages{0};
+            VkPipelineStageFlags dstStages{0};
+        };
+
+        // Memory shared by images whose lifetimes do not overlap.
+        struct MemorySlot
+        {
+            VkDeviceSize size{0};
+            VkDeviceSize alignment{1};
+            uint32_t memoryTypeBits{~0u};
+            uint32_t lastPass{0};
+        };
+
+        // Called for each transient image once its extent and usage are known, returns its memory
+        // requirements.
+        using RequirementsCallback = std::function<VkMemoryRequirements(LveRenderGraphResource image)>;
+
+        LveRenderGraphPlan();
+
+        LveRenderGraphResource createImage(const std::string &name, const LveRenderGraphImageInfo &info);
+        LveRenderGraphResource getBackbuffer() const { return backbuffer; }
+        // Returns the pass index, passes run in the order they were added.
+        uint32_t addPass(const std::string &name, const std::function<void(PassBuilder &builder)> &setup);
+        // Only for the backbuffer pass, which records the same way whatever the contents.
+        void setContents(uint32_t pass, VkSubpassContents contents);
+
+        void compile(VkExtent2D swapChainExtent, const RequirementsCallback &getRequirements);
+
+        const std::vector<Image> &getImages() const { return images; }
+        const std::vector<Pass> &getPasses() const { return passes; }
+        const std::vector<MemorySlot> &getSlots() const { return slots; }
+        uint32_t getBackbufferPass() const { return backbufferPass; }
+        const LveRenderGraphStats &getStats() const { return stats; }
+
+        static bool isDepthFormat(VkFormat format);
+
+    private:
+        // How a pass uses an image, which decides the layout and what has to be waited for.
+        struct Access
+        {
+            VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+            VkPipelineStageFlags stages{0};
+            VkAccessFlags access{0};
+        };
+
+        void cullPasses();
+        void packImages(VkExtent2D swapChainExtent, const RequirementsCallback &getRequirements);
+        void chooseAttachmentOps();
+        void computeBarriers();
+
+        Access passAccess(const Pass &pass, LveRenderGraphResource image, bool loads) const;
+        bool isFirstWrite(uint32_t pass, LveRenderGraphResource image) const;
+        bool isUsedAfter(uint32_t pass, LveRenderGraphResource image) const;
+
+        std::vector<Image> images{};
+        std::vector<Pass> passes{};
+        std::vector<MemorySlot> slots{};
+        LveRenderGraphResource backbuffer;
+        uint32_t backbufferPass{NO_PASS};
+        LveRenderGraphStats stats{};
+    };
+}
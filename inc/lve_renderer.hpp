@@ -4,6 +4,7 @@
 #include "lve_swap_chain.hpp"
 #include "lve_model.hpp"
 
+#include <functional>
 #include <memory>
 #include <vector>
 #include <cassert>
@@ -13,45 +14,144 @@ namespace lve
     class LveRenderer
     {
     public:
-        LveRenderer(LveWindow &window, LveDevice &device);
+        // workerCount threads may record secondary command buffers concurrently, one per worker index.
+        LveRenderer(
+            LveWindow &window,
+            LveDevice &device,
+            uint32_t workerCount = 0,
+            const LveFrameSettings &frameSettings = {});
+        // Headless, renders to the offscreen images of a headless device at a fixed extent.
+        LveRenderer(
+            LveDevice &device,
+            VkExtent2D extent,
+            uint32_t workerCount = 0,
+            const LveFrameSettings &frameSettings = {});
         ~LveRenderer();
 
         LveRenderer(const LveRenderer &) = delete;
         LveRenderer &operator=(const LveRenderer &) = delete;
 
         bool isFrameInProgress() const { return isFrameStarted; }
+        bool isHeadless() const { return lveWindow == nullptr; }
+        // True while the window is minimized, beginFrame() returns nullptr until it is restored.
+        bool isSuspended() const { return swapChainSuspended; }
+        // Changes when a recreated swap chain has another color or depth format, pipelines built
+        // against getSwapChainRenderPass() must be recreated then. Resizing alone keeps it.
+        uint32_t getSwapChainFormatVersion() const { return swapChainFormatVersion; }
         float getAspectRatio() const { return lveSwapChain->extentAspectRatio(); }
+        VkExtent2D getSwapChainExtent() const { return lveSwapChain->getSwapChainExtent(); }
 
         VkRenderPass getSwapChainRenderPass() const { return lveSwapChain->getRenderPass(); }
+        // Replaced when the swap chain is recreated, so only valid until the next beginFrame().
+        LveSwapChain &getSwapChain() const { return *lveSwapChain; }
+        // Images the current frame renders to, for copies recorded after endSwapChainRenderPass.
+        VkImage getCurrentImage() const
+        {
+            assert(isFrameStarted && "Cannot get image when frame not in progress.");
+            return lveSwapChain->getImage(static_cast<int>(currentImageIndex));
+        }
+        VkImage getCurrentDepthImage() const
+        {
+            assert(isFrameStarted && "Cannot get depth image when frame not in progress.");
+            return lveSwapChain->getDepthImage(static_cast<int>(currentImageIndex));
+        }
         VkCommandBuffer getCurrentCommandBuffer() const
         {
             assert(isFrameStarted && "Cannot get command buffer when frame not in progress.");
-            return commandBuffers[currentFrameIndex];
+            return frames[lveSwapChain->currentFrameIndex()].commandBuffer;
         }
 
         int getFrameIndex() const
         {
             assert(isFrameStarted && "Cannot get frame index when frame not in progress.");
-            return currentFrameIndex;
+            return static_cast<int>(lveSwapChain->currentFrameIndex());
+        }
+        // Frames in flight, the number of slots getFrameIndex() cycles through.
+        uint32_t getFrameCount() const { return static_cast<uint32_t>(frames.size()); }
+
+        // Applied by recreating the swap chain when the next frame begins.
+        void setFrameSettings(const LveFrameSettings &settings);
+        const LveFrameSettings &getFrameSettings() const { return frameSettings; }
+        void setPresentPolicy(LvePresentPolicy policy);
+        // What the policy resolved to, updated once the swap chain has been recreated.
+        VkPresentModeKHR getPresentMode() const { return lveSwapChain->getPresentMode(); }
+        // Sizes a per-frame resource kept outside the renderer. Called right away and again each
+        // time the frame count changes, with the device idle so the old resources may be destroyed.
+        void addFrameCountCallback(std::function<void(uint32_t frameCount)> callback);
+
+        // Graphics timeline value the frame being recorded signals once it completes, resources it
+        // uses can be released when lveDevice.graphicsTimeline().isComplete(frameNumber).
+        uint64_t getFrameNumber() const
+        {
+            assert(isFrameStarted && "Cannot get frame number when frame not in progress.");
+            return lveDevice.graphicsTimeline().pendingValue();
         }
 
         VkCommandBuffer beginFrame();
         void endFrame();
-        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the pass may only execute secondary
+        // command buffers from beginSecondaryCommandBuffer().
+        void beginSwapChainRenderPass(
+            VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+        // Begins a secondary command buffer continuing the swap chain render pass, taken from the
+        // worker's pool for the current frame. Each worker index must only be used by one thread
+        // at a time. The pools are reset as a whole when the frame comes around again.
+        VkCommandBuffer beginSecondaryCommandBuffer(uint32_t worker);
+        void endSecondaryCommandBuffer(VkCommandBuffer commandBuffer);
+        uint32_t getWorkerCount() const { return workerCount; }
+
     private:
-        void createCommandBuffers();
-        void freeCommandBuffers();
+        VkExtent2D getTargetExtent() { return lveWindow != nullptr ? lveWindow->getExtent() : headlessExtent; }
+        void createFrameContexts();
+        void destroyFrameContexts();
         void recreateSwapChain();
+        void setViewportAndScissor(VkCommandBuffer commandBuffer);
+
+        struct WorkerCommandPool
+        {
+            VkCommandPool pool{VK_NULL_HANDLE};
+            std::vector<VkCommandBuffer> commandBuffers{};
+            // Buffers handed out since the last reset.
+            uint32_t usedCount{0};
+        };
+
+        // Command recording resources of one frame in flight, all reset together when the frame
+        // comes around again instead of buffer by buffer. Recreated with the swap chain when the
+        // frame count changes.
+        struct FrameContext
+        {
+            VkCommandPool commandPool{VK_NULL_HANDLE};
+            VkCommandBuffer commandBuffer{VK_NULL_HANDLE};
+            std::vector<WorkerCommandPool> workerPools{};
+        };
+
+        // Swap chain replaced by recreateSwapChain, destroyed once acquireCount reaches
+        // releaseAcquire.
+        struct RetiredSwapChain
+        {
+            std::shared_ptr<LveSwapChain> swapChain;
+            uint64_t releaseAcquire;
+        };
 
-        LveWindow &lveWindow;
+        // Null when headless.
+        LveWindow *lveWindow;
         LveDevice &lveDevice;
+        VkExtent2D headlessExtent{};
         std::unique_ptr<LveSwapChain> lveSwapChain;
-        std::vector<VkCommandBuffer> commandBuffers;
+        std::vector<RetiredSwapChain> retiredSwapChains{};
+        // Images acquired so far, across swap chains.
+        uint64_t acquireCount{0};
+        uint32_t workerCount;
+        LveFrameSettings frameSettings;
+        bool frameSettingsChanged{false};
+        std::vector<FrameContext> frames{};
+        std::vector<std::function<void(uint32_t)>> frameCountCallbacks{};
 
         uint32_t currentImageIndex;
-        int currentFrameIndex{0};
         bool isFrameStarted{false};
+        bool swapChainSuspended{false};
+        uint32_t swapChainFormatVersion{0};
     };
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_geometry_arena.hpp"
+#include "lve_model.hpp"
+#include "lve_upload_batcher.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lve
+{
+    struct LveResidencyStats
+    {
+        uint32_t residentCount{0};
+        uint32_t evictedCount{0};
+        VkDeviceSize residentBytes{0};
+        VkDeviceSize evictedBytes{0};
+        uint64_t evictions{0};
+        uint64_t restores{0};
+    };
+
+    // Keeps model geometry within the device local memory budget. Tracked models are ordered by
+    // the frame they were last bound in, and when usage goes over the budget the least recently
+    // drawn ones are read back to a CPU copy, or to a file in the spill directory when one is set,
+    // and their arena ranges released. Binding an evicted model uploads it again.
+    //
+    // Only models whose last frame has completed on the graphics timeline are evicted, so the GPU
+    // is done with them. Evicting and restoring both change the geometry arena's blocks, so they
+    // only happen in track(), update() and makeResident(), on the thread that owns the arena.
+    // Recording threads only call touch(), which just records the frame.
+    class LveResidencyManager
+    {
+    public:
+        // Share of the device local budget usage is kept under, headroom for new arena blocks.
+        static constexpr float BUDGET_USAGE_LIMIT{0.9f};
+
+        LveResidencyManager(
+            LveDevice &device,
+            LveGeometryArena &geometryArena,
+            LveUploadBatcher &uploadBatcher,
+            const std::string &spillDirectory = "");
+        ~LveResidencyManager();
+
+        LveResidencyManager(const LveResidencyManager &) = delete;
+        LveResidencyManager &operator=(const LveResidencyManager &) = delete;
+
+        // Evicts older models right away if the new one pushes usage over the budget.
+        void track(LveModel &model);
+        void untrack(LveModel &model);
+        // Marks the model as drawn this frame. Called by LveModel::bind, thread safe, the model
+        // must be resident.
+        void touch(LveModel &model);
+        // Call once per frame, models drawn by frames that completed since become evictable.
+        void update();
+        // Brings an evicted model's geometry back, call for every model a frame draws after
+        // update() and before recording. The uploads are queued on the upload batcher, which has
+        // to be flushed before the frame is submitted. Restores may exceed the budget until the
+        // next update().
+        void makeResident(LveModel &model);
+
+        LveResidencyStats getStats();
+
+    private:
+        struct Entry
+        {
+            // Graphics timeline value of the last frame that drew the model, written by touch() from
+            // any recording thread. 0 until the first draw, which is always complete.
+            std::atomic<uint64_t> lastUsedFrame{0};
+            // Mirrors model->isResident(), readable from recording threads.
+            std::atomic<bool> resident{true};
+            // Evicted geometry, empty when resident or spilled to spillPath.
+            std::vector<char> data{};
+            std::string spillPath{};
+            VkDeviceSize size{0};
+        };
+
+        // Bytes the arena may use before device local usage exceeds the budget.
+        VkDeviceSize geometryBudget();
+        void evictToBudget(VkDeviceSize extraBytes);
+        void evict(LveModel &model, Entry &entry);
+        void restore(LveModel &model, Entry &entry);
+
+        LveDevice &lveDevice;
+        LveGeometryArena &geometryArena;
+        LveUploadBatcher &uploadBatcher;
+        std::string spillDirectory;
+
+        // Guards entries against getStats() from other threads.
+        std::mutex mutex{};
+        std::unordered_map<LveModel *, Entry> entries{};
+        uint64_t spillCount{0};
+        uint64_t evictionCount{0};
+        uint64_t restoreCount{0};
+    };
+}
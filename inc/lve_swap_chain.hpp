@@ -13,13 +13,47 @@
 namespace lve
 {
 
+    // Trade-off between latency, tearing and power, mapped to the best present mode the surface
+    // supports. FIFO is always available, so every policy falls back to it.
+    enum class LvePresentPolicy
+    {
+        // MAILBOX, a new frame replaces the queued one without tearing.
+        LowestLatency,
+        // FIFO.
+        VSync,
+        // FIFO_RELAXED, late frames tear instead of waiting for the next vertical blank.
+        Adaptive,
+        // FIFO with as few images as the surface allows, unless imageCount asks for more.
+        PowerSaving,
+        // IMMEDIATE, then MAILBOX, frame rate limited only by rendering, for benchmarking.
+        Uncapped,
+    };
+
+    // Applied whenever the swap chain is created, so all may change at recreation.
+    struct LveFrameSettings
+    {
+        // Frames the CPU may record ahead of the GPU, 1 for the lowest latency and 3 for throughput.
+        uint32_t framesInFlight{2};
+        // Requested swap chain images, clamped to what the surface supports. 0 asks for one more
+        // than the minimum, or one per frame in flight when headless.
+        uint32_t imageCount{0};
+        LvePresentPolicy presentPolicy{LvePresentPolicy::LowestLatency};
+        // Stores depth at the end of the render pass so it can be read back, which costs the
+        // bandwidth of writing it out every frame.
+        bool readableDepth{false};
+    };
+
+    // On a headless device there is no surface to present to, the images are then an offscreen
+    // ring the chain cycles through itself, and frames are submitted without being presented.
     class LveSwapChain
     {
     public:
-        static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
-        LveSwapChain(LveDevice &deviceRef, VkExtent2D windowExtent);
-        LveSwapChain(LveDevice &deviceRef, VkExtent2D windowExtent, std::shared_ptr<LveSwapChain> previous);
+        LveSwapChain(LveDevice &deviceRef, VkExtent2D windowExtent, const LveFrameSettings &settings = {});
+        LveSwapChain(
+            LveDevice &deviceRef,
+            VkExtent2D windowExtent,
+            const LveFrameSettings &settings,
+            std::shared_ptr<LveSwapChain> previous);
         ~LveSwapChain();
 
         LveSwapChain(const LveSwapChain &) = delete;
@@ -28,8 +62,26 @@ namespace lve
         VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
         VkRenderPass getRenderPass() { return renderPass; }
         VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+        VkImage getImage(int index) { return swapChainImages[index]; }
+        VkImage getDepthImage(int index) { return depthImages[index]; }
+        // Layouts the render pass leaves the images in.
+        VkImageLayout getFinalLayout() const
+        {
+            return device.isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        }
+        VkImageLayout getFinalDepthLayout() const { return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL; }
+        // Whether the images may be the source of transfers, which the surface may not allow.
+        bool isColorReadable() const { return colorReadable; }
+        bool isDepthReadable() const { return settings.readableDepth; }
         size_t imageCount() { return swapChainImages.size(); }
+        uint32_t framesInFlight() const { return settings.framesInFlight; }
+        // The mode the policy resolved to on this surface.
+        VkPresentModeKHR getPresentMode() const { return presentMode; }
+        static const char *presentModeName(VkPresentModeKHR mode);
+        // Frame slot the next acquireNextImage / submitCommandBuffers pair uses.
+        uint32_t currentFrameIndex() const { return static_cast<uint32_t>(currentFrame); }
         VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
+        VkFormat getSwapChainDepthFormat() { return swapChainDepthFormat; }
         VkExtent2D getSwapChainExtent() { return swapChainExtent; }
         uint32_t width() { return swapChainExtent.width; }
         uint32_t height() { return swapChainExtent.height; }
@@ -40,7 +92,10 @@ namespace lve
         }
         VkFormat findDepthFormat();
 
+        // Waits until the frame submitted framesInFlight() frames ago has completed.
         VkResult acquireNextImage(uint32_t *imageIndex);
+        // Signals the next graphics timeline value along with the semaphore presentation waits on.
+        // Headless there is no presentation and only the timeline is signaled.
         VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
 
         bool compareSwapFormat(const LveSwapChain &swapChain) const
@@ -52,6 +107,7 @@ namespace lve
     private:
         void init();
         void createSwapChain();
+        void createOffscreenImages();
         void createImageViews();
         void createDepthResources();
         void createRenderPass();
@@ -62,33 +118,41 @@ namespace lve
         VkSurfaceFormatKHR chooseSwapSurfaceFormat(
             const std::vector<VkSurfaceFormatKHR> &availableFormats);
         VkPresentModeKHR chooseSwapPresentMode(
-            const std::vector<VkPresentModeKHR> &availablePresentModes);
+            const std::vector<VkPresentModeKHR> &availablePresentModes) const;
         VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities);
 
         VkFormat swapChainImageFormat;
         VkFormat swapChainDepthFormat;
         VkExtent2D swapChainExtent;
+        VkPresentModeKHR presentMode;
+        bool colorReadable = false;
 
         std::vector<VkFramebuffer> swapChainFramebuffers;
         VkRenderPass renderPass;
 
         std::vector<VkImage> depthImages;
-        std::vector<VkDeviceMemory> depthImageMemorys;
+        std::vector<LveAllocation> depthImageAllocations;
         std::vector<VkImageView> depthImageViews;
         std::vector<VkImage> swapChainImages;
         std::vector<VkImageView> swapChainImageViews;
+        // Only for offscreen images, swap chain images are owned by the swap chain.
+        std::vector<LveAllocation> colorImageAllocations;
 
         LveDevice &device;
         VkExtent2D windowExtent;
+        LveFrameSettings settings;
 
-        VkSwapchainKHR swapChain;
+        VkSwapchainKHR swapChain = VK_NULL_HANDLE;
         std::shared_ptr<LveSwapChain> oldSwapChain;
 
         std::vector<VkSemaphore> imageAvailableSemaphores;
         std::vector<VkSemaphore> renderFinishedSemaphores;
-        std::vector<VkFence> inFlightFences;
-        std::vector<VkFence> imagesInFlight;
+        // Graphics timeline values of the last submission per frame slot and per image, 0 if none.
+        std::vector<uint64_t> frameValues;
+        std::vector<uint64_t> imageValues;
         size_t currentFrame = 0;
+        // Offscreen image the next acquireNextImage hands out.
+        uint32_t nextImage = 0;
     };
 
 } // namespace lve
\ No newline at end of file
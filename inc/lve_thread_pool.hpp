@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lve
+{
+    // Fixed set of worker threads for splitting per-frame CPU work such as command recording.
+    class LveThreadPool
+    {
+    public:
+        // Defaults to one worker per hardware thread, leaving one for the main thread.
+        explicit LveThreadPool(uint32_t workerCount = defaultWorkerCount());
+        ~LveThreadPool();
+
+        LveThreadPool(const LveThreadPool &) = delete;
+        LveThreadPool &operator=(const LveThreadPool &) = delete;
+
+        // Runs task(index, worker) for every index below count and returns once all are done.
+        // worker identifies the thread running the task, so tasks can use per worker resources
+        // without locking. The first exception thrown by a task is rethrown here.
+        void parallelFor(uint32_t count, const std::function<void(uint32_t index, uint32_t worker)> &task);
+
+        uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+        static uint32_t defaultWorkerCount();
+
+    private:
+        void workerLoop(uint32_t worker);
+
+        std::vector<std::thread> workers{};
+
+        std::mutex mutex{};
+        std::condition_variable wakeCondition{};
+        std::condition_variable doneCondition{};
+        const std::function<void(uint32_t, uint32_t)> *task{nullptr};
+        uint32_t taskCount{0};
+        uint32_t nextTask{0};
+        uint32_t pendingTasks{0};
+        std::exception_ptr error{};
+        bool stopping{false};
+    };
+}
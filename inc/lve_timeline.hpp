@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace lve
+{
+    // Timeline semaphore counting the submissions to one queue that signal it. Each takes the next
+    // value, so waiting for a value waits for that submission and everything submitted before it,
+    // and anything holding a value can poll or wait for it without owning a fence.
+    class LveTimeline
+    {
+    public:
+        LveTimeline(
+            VkDevice device,
+            PFN_vkGetSemaphoreCounterValue getCounterValue,
+            PFN_vkWaitSemaphores waitSemaphores);
+        ~LveTimeline();
+
+        LveTimeline(const LveTimeline &) = delete;
+        LveTimeline &operator=(const LveTimeline &) = delete;
+
+        VkSemaphore getSemaphore() const { return semaphore; }
+
+        // Takes the value for a submission to signal. Submissions must reach the queue in the
+        // order their values were taken.
+        uint64_t nextValue() { return ++submittedValue; }
+        // The value the next submission will take.
+        uint64_t pendingValue() const { return submittedValue + 1; }
+        uint64_t getSubmittedValue() const { return submittedValue; }
+
+        // Queries the semaphore, isComplete only does when the last known value is behind.
+        uint64_t getCompletedValue();
+        bool isComplete(uint64_t value);
+        // Returns false on timeout. The value must already have been taken by a submission.
+        bool wait(uint64_t value, uint64_t timeout = UINT64_MAX);
+
+    private:
+        void updateCompletedValue(uint64_t value);
+
+        VkDevice device;
+        PFN_vkGetSemaphoreCounterValue getCounterValue;
+        PFN_vkWaitSemaphores waitSemaphores;
+        VkSemaphore semaphore;
+
+        std::atomic<uint64_t> submittedValue{0};
+        // Last value seen complete, never ahead of the semaphore.
+        std::atomic<uint64_t> completedValue{0};
+    };
+}
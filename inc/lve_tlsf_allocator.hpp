@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace lve
+{
+    // Two-level segregated fit range allocator (Masmano et al. 2004) over [0, capacity) in
+    // abstract units. Free ranges are binned by the position of their highest bit and SL_COUNT
+    // linear subdivisions below it, so allocate and free are constant time: two bitmap scans find
+    // a non-empty bin whose every range fits, and freed ranges merge with free neighbours.
+    //
+    // Only offsets are tracked; what a unit means (a byte, a vertex) is up to the owner.
+    class LveTlsfAllocator
+    {
+    public:
+        static constexpr uint32_t INVALID_NODE{UINT32_MAX};
+
+        explicit LveTlsfAllocator(uint64_t capacity);
+
+        LveTlsfAllocator(const LveTlsfAllocator &) = delete;
+        LveTlsfAllocator &operator=(const LveTlsfAllocator &) = delete;
+        LveTlsfAllocator(LveTlsfAllocator &&) = default;
+        LveTlsfAllocator &operator=(LveTlsfAllocator &&) = default;
+
+        // Returns INVALID_NODE when no free range of size units is left, otherwise a node to pass
+        // to free() with offset set to the start of the range, a multiple of alignment.
+        uint32_t allocate(uint64_t size, uint64_t &offset, uint64_t alignment = 1);
+        void free(uint32_t node);
+
+        uint64_t getCapacity() const { return capacity; }
+        uint64_t getFreeSize() const { return freeSize; }
+
+    private:
+        static constexpr uint32_t SL_LOG2{4};
+        static constexpr uint32_t SL_COUNT{1u << SL_LOG2};
+        static constexpr uint32_t FL_COUNT{64 - SL_LOG2 + 1};
+
+        struct Node
+        {
+            uint64_t offset{0};
+            uint64_t size{0};
+            uint32_t prevPhysical{INVALID_NODE};
+            uint32_t nextPhysical{INVALID_NODE};
+            uint32_t prevFree{INVALID_NODE};
+            uint32_t nextFree{INVALID_NODE};
+            bool free{false};
+        };
+
+        static void mapping(uint64_t size, uint32_t &fl, uint32_t &sl);
+        uint32_t findFree(uint64_t size) const;
+
+        uint32_t createNode();
+        void releaseNode(uint32_t node);
+        void insertFree(uint32_t node);
+        void removeFree(uint32_t node);
+
+        uint64_t capacity;
+        uint64_t freeSize;
+
+        std::vector<Node> nodes{};
+        std::vector<uint32_t> unusedNodes{};
+
+        uint64_t flBitmap{0};
+        uint32_t slBitmaps[FL_COUNT]{};
+        uint32_t freeHeads[FL_COUNT][SL_COUNT]{};
+    };
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_buffer.hpp"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace lve
+{
+    // Identifies the batch an upload was recorded into. Batches complete in submission order, so
+    // one id is enough to tell whether an upload has landed. Ids of submitted batches are
+    // transfer timeline values.
+    struct LveUploadHandle
+    {
+        uint64_t batch{0};
+    };
+
+    // Records buffer uploads through a persistently mapped staging ring into batches, one command
+    // buffer per batch, instead of a submit and vkQueueWaitIdle per copy. Each batch signals the
+    // next value of the device's transfer timeline, which is the batch id handles refer to.
+    //
+    // Copies run on the device's transfer queue. When that is a dedicated family, each batch
+    // releases the written ranges to the graphics family, and a small graphics submission waits
+    // for the batch's timeline value and acquires them, so uploads overlap rendering instead of
+    // queueing behind it. Either way draws submitted to the graphics queue after flush() see the
+    // data without waiting on the CPU. Staging space is recycled as batches retire; when the ring
+    // is full, upload() submits and waits for the oldest batches.
+    class LveUploadBatcher
+    {
+    public:
+        static constexpr VkDeviceSize STAGING_SIZE{32 * 1024 * 1024};
+        static constexpr VkDeviceSize STAGING_ALIGNMENT{16};
+
+        LveUploadBatcher(LveDevice &device);
+        ~LveUploadBatcher();
+
+        LveUploadBatcher(const LveUploadBatcher &) = delete;
+        LveUploadBatcher &operator=(const LveUploadBatcher &) = delete;
+
+        // Copies data into staging immediately, so it may be released on return. The transfer
+        // itself runs once the batch is flushed.
+        LveUploadHandle upload(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void *data, VkDeviceSize size);
+
+        // Submits the batch being recorded, if any, and retires completed ones.
+        void flush();
+        bool isComplete(LveUploadHandle handle);
+        // Flushes first if the handle belongs to the batch being recorded.
+        void wait(LveUploadHandle handle);
+        void waitIdle();
+
+    private:
+        struct Batch
+        {
+            // Transfer timeline value once submitted, a placeholder past the last one while recording.
+            uint64_t id{0};
+            VkCommandBuffer commandBuffer{VK_NULL_HANDLE};
+            // Ownership acquire on the graphics queue, only with a dedicated transfer family. Free
+            // again once acquireFrame is reached on the graphics timeline, as frames are the only
+            // graphics submissions signaling it.
+            VkCommandBuffer acquireCommandBuffer{VK_NULL_HANDLE};
+            uint64_t acquireFrame{0};
+            // Ring position past this batch's staging data, freed when the batch retires.
+            uint64_t stagingEnd{0};
+        };
+
+        void beginBatch();
+        void addOwnershipBarrier(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+        void submitBatch();
+        void submitOwnershipAcquire();
+        VkDeviceSize reserveStaging(VkDeviceSize size);
+        void retireCompleted();
+        void retireOldest();
+
+        LveDevice &lveDevice;
+        // Batches retire one at a time, so their buffers are reset individually.
+        VkCommandPool commandPool;
+        VkCommandPool acquireCommandPool{VK_NULL_HANDLE};
+        uint32_t transferFamily;
+        uint32_t graphicsFamily;
+        bool ownershipTransfer;
+        std::unique_ptr<LveBuffer> stagingBuffer;
+        char *stagingData{nullptr};
+
+        // Monotonic byte counters, taken modulo STAGING_SIZE for ring positions.
+        uint64_t stagingHead{0};
+        uint64_t stagingTail{0};
+
+        bool recording{false};
+        Batch current{};
+        // Ranges written by the batch being recorded, merged where contiguous.
+        std::vector<VkBufferMemoryBarrier> ownershipBarriers{};
+        std::deque<Batch> inFlight{};
+        std::vector<Batch> idleBatches{};
+        uint64_t completedBatchId{0};
+    };
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+#include <vector>
+
+namespace lve
+{
+    // Open-addressing (Robin Hood) table deduplicating vertices into a caller owned vertex array.
+    // Slots only hold the hash and the index of the vertex in that array, so every unique vertex
+    // is stored exactly once and the table itself is a single flat allocation.
+    //
+    // Vertices are hashed and compared on their raw bytes, with -0.0 folded onto +0.0 so that
+    // the result matches Vertex::operator==.
+    class LveVertexTable
+    {
+    public:
+        LveVertexTable(std::vector<LveModel::Vertex> &vertices, size_t expectedVertexCount = 0);
+
+        LveVertexTable(const LveVertexTable &) = delete;
+        LveVertexTable &operator=(const LveVertexTable &) = delete;
+
+        // Returns the index of the vertex, appending it to the vertex array if it is new.
+        uint32_t insert(const LveModel::Vertex &vertex);
+
+    private:
+        static constexpr uint32_t EMPTY{UINT32_MAX};
+        static constexpr size_t WORD_COUNT{sizeof(LveModel::Vertex) / sizeof(uint32_t)};
+
+        struct Slot
+        {
+            uint32_t hash{0};
+            uint32_t index{EMPTY};
+        };
+
+        void rehash(size_t slotCount);
+        void place(Slot slot, size_t position, size_t distance);
+        bool matches(const uint32_t (&words)[WORD_COUNT], uint32_t index) const;
+
+        std::vector<LveModel::Vertex> &vertices;
+        std::vector<Slot> slots{};
+        size_t mask{0};
+        size_t count{0};
+    };
+}
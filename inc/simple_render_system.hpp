@@ -5,6 +5,8 @@
 #include "lve_game_object.hpp"
 #include "lve_device.hpp"
 #include "lve_frame_info.hpp"
+#include "lve_renderer.hpp"
+#include "lve_thread_pool.hpp"
 
 #include <memory>
 #include <vector>
@@ -14,6 +16,11 @@ namespace lve
     class SimpleRenderSystem
     {
     public:
+        // Coarsest detail level is used whose simplification error projects to at most this many pixels.
+        static constexpr float LOD_PIXEL_ERROR{1.f};
+        // Fewest objects worth a secondary command buffer of their own in parallel recording.
+        static constexpr size_t PARALLEL_BATCH_SIZE{1024};
+
         SimpleRenderSystem(
             LveDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
         ~SimpleRenderSystem();
@@ -22,14 +29,30 @@ namespace lve
         SimpleRenderSystem &operator=(const SimpleRenderSystem &) = delete;
 
         void renderGameObjects(FrameInfo &frameInfo, std::vector<LveGameObject> &gameObjects);
+        // Records contiguous batches of objects into secondary command buffers on the pool's
+        // workers and executes them in order. The render pass must have been begun with
+        // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+        void renderGameObjectsParallel(
+            FrameInfo &frameInfo,
+            std::vector<LveGameObject> &gameObjects,
+            LveRenderer &renderer,
+            LveThreadPool &threadPool);
 
     private:
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
         void createPipeline(VkRenderPass renderPass);
+        void recordGameObjects(
+            const FrameInfo &frameInfo,
+            VkCommandBuffer commandBuffer,
+            std::vector<LveGameObject> &gameObjects,
+            size_t first,
+            size_t last);
+        uint32_t selectLod(const FrameInfo &frameInfo, const LveModel &model, const glm::mat4 &modelMatrix) const;
 
         LveDevice &lveDevice;
 
         std::unique_ptr<LvePipeline> lvePipeline;
+        std::unique_ptr<LvePipeline> compactPipeline;
         VkPipelineLayout pipelineLayout;
     };
 }
\ No newline at end of file
@@ -0,0 +1,39 @@
+#version 450
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 color;
+layout (location = 2) in vec2 octahedralNormal;
+layout (location = 3) in vec2 uv;
+
+layout (location = 0) out vec3 fragColor;
+
+layout (set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projectionViewMatrix;
+    vec3 directionToLight;
+} ubo;
+
+// modelMatrix already contains the mesh bounds decode for the UNORM16 positions
+layout (push_constant) uniform Push {
+    mat4 modelMatrix;
+    mat4 normalMatrix;
+} push;
+
+const float AMBIENT = 0.02;
+
+vec3 octahedralDecode(vec2 encoded) {
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -fold : fold;
+    n.y += n.y >= 0.0 ? -fold : fold;
+    return normalize(n);
+}
+
+void main() {
+    gl_Position = ubo.projectionViewMatrix * push.modelMatrix * vec4(position, 1.0);
+
+    vec3 normalWorldSpace = normalize(mat3(push.normalMatrix) * octahedralDecode(octahedralNormal));
+
+    float lightIntensity = AMBIENT + max(dot(normalWorldSpace, ubo.directionToLight), 0);
+
+    fragColor = lightIntensity * color;
+}
@@ -1,9 +1,9 @@
 #include "first_app.hpp"
 
 #include "lve_camera.hpp"
+#include "lve_render_graph.hpp"
 #include "simple_render_system.hpp"
 #include "keyboard_movement_controller.hpp"
-#include "lve_buffer.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -25,112 +25,236 @@ namespace lve
         glm::vec3 lightDirection = glm::normalize(glm::vec3{1.f, -3.f, -1.f});
     };
 
-    FirstApp::FirstApp()
+    FirstApp::FirstApp(
+        const LveFrameSettings &frameSettings, uint32_t headlessFrameCount, const std::string &captureDirectory)
+        : headlessFrameCount{headlessFrameCount},
+          captureDirectory{captureDirectory},
+          lveWindow{headlessFrameCount > 0 ? nullptr : std::make_unique<LveWindow>(WIDTH, HEIGHT, "Hello Vulkan!")}
     {
+        if (lveWindow == nullptr)
+        {
+            lveRenderer = std::make_unique<LveRenderer>(
+                lveDevice, VkExtent2D{WIDTH, HEIGHT}, threadPool.getWorkerCount(), frameSettings);
+        }
+        else
+        {
+            lveRenderer = std::make_unique<LveRenderer>(
+                *lveWindow, lveDevice, threadPool.getWorkerCount(), frameSettings);
+        }
+
         globalPool =
             LveDescriptorPool::Builder(lveDevice)
-                .setMaxSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT)
-                .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+                .setMaxSets(1)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
                 .build();
 
+        globalSetLayout =
+            LveDescriptorSetLayout::Builder(lveDevice)
+                .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT)
+                .build();
+        lveRenderer->addFrameCountCallback([this](uint32_t frameCount) { createFrameRing(frameCount); });
+
         loadGameObjects();
+        uploadBatcher.flush();
+
+        auto memoryStats{lveDevice.memoryAllocator().getStats()};
+        std::cout << "Device memory: " << memoryStats.allocationCount << " allocations in "
+                  << memoryStats.blockCount << " blocks and " << memoryStats.dedicatedCount << " dedicated, "
+                  << memoryStats.usedBytes / (1024.f * 1024.f) << " of "
+                  << memoryStats.reservedBytes / (1024.f * 1024.f) << " MB used\n";
     }
 
     FirstApp::~FirstApp() {}
 
-    void FirstApp::run()
+    void FirstApp::createFrameRing(uint32_t frameCount)
     {
-        std::vector<std::unique_ptr<LveBuffer>> uboBuffers(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
-        for (int i{0}; i < uboBuffers.size(); ++i)
+        frameRing = std::make_unique<LveFrameRingBuffer>(
+            lveDevice, FRAME_RING_SIZE, frameCount, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+
+        auto bufferInfo{frameRing->descriptorInfo(sizeof(GlobalUbo))};
+        LveDescriptorWriter writer{*globalSetLayout, *globalPool};
+        writer.writeBuffer(0, &bufferInfo);
+        if (globalDescriptorSet == VK_NULL_HANDLE)
         {
-            uboBuffers[i] = std::make_unique<LveBuffer>(
-                lveDevice,
-                sizeof(GlobalUbo),
-                1,
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-            uboBuffers[i]->map();
+            writer.build(globalDescriptorSet);
         }
-
-        auto globalSetLayout{
-            LveDescriptorSetLayout::Builder(lveDevice)
-                .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
-                .build()};
-
-        std::vector<VkDescriptorSet> globalDescriptorSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
-        for (int i{0}; i < globalDescriptorSets.size(); ++i)
+        else
         {
-            auto bufferInfo{uboBuffers[i]->descriptorInfo()};
-            LveDescriptorWriter(*globalSetLayout, *globalPool)
-                .writeBuffer(0, &bufferInfo)
-                .build(globalDescriptorSets[i]);
+            writer.overwrite(globalDescriptorSet);
         }
+    }
 
-        SimpleRenderSystem simpleRenderSystem{
+    void FirstApp::run()
+    {
+        auto simpleRenderSystem{std::make_unique<SimpleRenderSystem>(
             lveDevice,
-            lveRenderer.getSwapChainRenderPass(),
-            globalSetLayout->getDescriptorSetLayout()};
+            lveRenderer->getSwapChainRenderPass(),
+            globalSetLayout->getDescriptorSetLayout())};
+        uint32_t swapChainFormatVersion{lveRenderer->getSwapChainFormatVersion()};
         LveCamera camera{};
 
         auto viewerObject{LveGameObject::createGameObject()};
         KeyboardMovementController cameraController{};
 
         auto currentTime{std::chrono::high_resolution_clock::now()};
+        const auto startTime{currentTime};
+        uint32_t renderedFrames{0};
+
+        // the frame is recorded through the render graph, so passes can be added ahead of the swap
+        // chain pass. The pass draws whatever frame the loop points it at
+        FrameInfo *currentFrame{nullptr};
+        bool parallelRecording{false};
+        LveRenderGraph renderGraph{lveDevice, *lveRenderer};
+        renderGraph.addPass(
+            "main",
+            [&renderGraph](LveRenderGraph::PassBuilder &builder) { builder.writeColor(renderGraph.getBackbuffer()); },
+            [&](VkCommandBuffer)
+            {
+                if (parallelRecording)
+                {
+                    simpleRenderSystem->renderGameObjectsParallel(*currentFrame, gameObjects, *lveRenderer, threadPool);
+                }
+                else
+                {
+                    simpleRenderSystem->renderGameObjects(*currentFrame, gameObjects);
+                }
+            });
+
+        // the writer outlives the readback, whose callbacks write to it
+        std::unique_ptr<LveFrameWriter> frameWriter{};
+        std::unique_ptr<LveFrameReadback> frameReadback{};
+        if (!captureDirectory.empty())
+        {
+            frameWriter = std::make_unique<LveFrameWriter>(captureDirectory);
+            frameReadback = std::make_unique<LveFrameReadback>(lveDevice, *lveRenderer);
+        }
 
-        while (!lveWindow.shouldClose())
+        while (lveWindow != nullptr ? !lveWindow->shouldClose() : renderedFrames < headlessFrameCount)
         {
-            glfwPollEvents();
+            if (lveWindow != nullptr)
+            {
+                // nothing is drawn while minimized, so block instead of spinning
+                if (lveRenderer->isSuspended())
+                {
+                    glfwWaitEvents();
+                }
+                else
+                {
+                    glfwPollEvents();
+                }
+            }
 
             auto newTime{std::chrono::high_resolution_clock::now()};
             float frameTime{
                 std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count()};
             currentTime = newTime;
 
-            cameraController.moveInPlaneXZ(lveWindow.getGLFWwindow(), frameTime, viewerObject);
+            if (lveWindow != nullptr)
+            {
+                cameraController.moveInPlaneXZ(lveWindow->getGLFWwindow(), frameTime, viewerObject);
+            }
             camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
 
-            float aspect{lveRenderer.getAspectRatio()};
+            float aspect{lveRenderer->getAspectRatio()};
             camera.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 10.f);
 
-            if (auto commandBuffer{lveRenderer.beginFrame()})
+            // geometry queued since the last frame is submitted ahead of the frame that draws it
+            uploadBatcher.flush();
+            if (frameReadback != nullptr)
             {
-                int frameIndex{lveRenderer.getFrameIndex()};
+                frameReadback->update();
+            }
+
+            if (auto commandBuffer{lveRenderer->beginFrame()})
+            {
+                // the old pipeline is only destroyed once frames in flight are done with it
+                if (swapChainFormatVersion != lveRenderer->getSwapChainFormatVersion())
+                {
+                    simpleRenderSystem = std::make_unique<SimpleRenderSystem>(
+                        lveDevice,
+                        lveRenderer->getSwapChainRenderPass(),
+                        globalSetLayout->getDescriptorSetLayout());
+                    swapChainFormatVersion = lveRenderer->getSwapChainFormatVersion();
+                }
+
+                int frameIndex{lveRenderer->getFrameIndex()};
+                residencyManager.update();
+                // arena blocks may only change here, recording threads just timestamp the models
+                for (auto &obj : gameObjects)
+                {
+                    residencyManager.makeResident(*obj.model);
+                }
+                uploadBatcher.flush();
+                frameRing->beginFrame(frameIndex);
+
+                // update uniform buffer
+                GlobalUbo ubo{};
+                ubo.projectionView = camera.getProjection() * camera.getView();
+                auto uboAllocation{frameRing->write(&ubo, sizeof(ubo))};
+
                 FrameInfo frameInfo{
                     frameIndex,
                     frameTime,
                     commandBuffer,
                     camera,
-                    globalDescriptorSets[frameIndex]};
+                    globalDescriptorSet,
+                    uboAllocation.dynamicOffset,
+                    lveRenderer->getSwapChainExtent()};
 
-                // update uniform buffer
-                GlobalUbo ubo{};
-                ubo.projectionView = camera.getProjection() * camera.getView();
-                uboBuffers[frameIndex]->writeToBuffer(&ubo);
-                uboBuffers[frameIndex]->flush();
-
-                // render
-                lveRenderer.beginSwapChainRenderPass(commandBuffer);
-                simpleRenderSystem.renderGameObjects(frameInfo, gameObjects);
-                lveRenderer.endSwapChainRenderPass(commandBuffer);
-                lveRenderer.endFrame();
+                // render, on the worker threads once there is enough to split
+                parallelRecording = gameObjects.size() >= 2 * SimpleRenderSystem::PARALLEL_BATCH_SIZE &&
+                                    threadPool.getWorkerCount() > 1;
+                renderGraph.setBackbufferContents(
+                    parallelRecording ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+                currentFrame = &frameInfo;
+                renderGraph.execute(commandBuffer);
+                currentFrame = nullptr;
+                if (frameReadback != nullptr)
+                {
+                    frameReadback->capture(
+                        commandBuffer,
+                        [&frameWriter](const LveReadbackFrame &frame) { frameWriter->write(frame); });
+                }
+                frameRing->endFrame();
+                lveRenderer->endFrame();
+                ++renderedFrames;
             }
         }
 
         vkDeviceWaitIdle(lveDevice.device());
+
+        if (frameReadback != nullptr)
+        {
+            frameReadback->flush();
+            std::cout << "Captured " << renderedFrames - frameReadback->getDroppedCount() << " frames to "
+                      << captureDirectory << ", dropped " << frameReadback->getDroppedCount() << '\n';
+        }
+
+        if (lveWindow == nullptr && renderedFrames > 0)
+        {
+            float totalTime{std::chrono::duration<float, std::chrono::milliseconds::period>(
+                                std::chrono::high_resolution_clock::now() - startTime)
+                                .count()};
+            std::cout << "Rendered " << renderedFrames << " headless frames in " << totalTime << " ms, "
+                      << totalTime / renderedFrames << " ms per frame\n";
+        }
     }
 
     void FirstApp::loadGameObjects()
     {
         std::shared_ptr<LveModel> lveModel{
-            LveModel::createModelFromFile(lveDevice, "models/flat_vase.obj")};
+            LveModel::createModelFromFile(geometryArena, "models/flat_vase.obj")};
         auto flatVase{LveGameObject::createGameObject()};
+        residencyManager.track(*lveModel);
         flatVase.model = lveModel;
         flatVase.transform.translation = {-.5f, .5f, 2.5f};
         flatVase.transform.scale = {3.f, 1.5f, 3.f};
         gameObjects.push_back(std::move(flatVase));
 
-        lveModel = LveModel::createModelFromFile(lveDevice, "models/smooth_vase.obj");
+        lveModel = LveModel::createModelFromFile(
+            geometryArena, "models/smooth_vase.obj", true, LveModel::VertexFormat::Compact);
         auto smoothVase{LveGameObject::createGameObject()};
+        residencyManager.track(*lveModel);
         smoothVase.model = lveModel;
         smoothVase.transform.translation = {.5f, .5f, 2.5f};
         smoothVase.transform.scale = {3.f, 1.5f, 3.f};
@@ -1,5 +1,6 @@
 #include "lve_buffer.hpp"
 
+#include <algorithm>
 #include <cassert>
 
 namespace lve
@@ -28,29 +29,32 @@ namespace lve
           alignmentSize{getAlignment(instanceSize, minOffsetAlignment)}
     {
         bufferSize = alignmentSize * instanceCount;
-        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation);
     }
 
     LveBuffer::~LveBuffer()
     {
         unmap();
-        vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
-        vkFreeMemory(lveDevice.device(), memory, nullptr);
+        lveDevice.destroyBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation);
     }
 
+    // host visible memory is mapped once by the allocator, so mapping only hands out the pointer
     VkResult LveBuffer::map(VkDeviceSize size, VkDeviceSize offset)
     {
-        assert(buffer && memory && "Called map on buffer before create.");
-        return vkMapMemory(lveDevice.device(), memory, offset, size, 0, &mapped);
+        assert(buffer && allocation.memory && "Called map on buffer before create.");
+        assert(offset <= bufferSize && (size == VK_WHOLE_SIZE || size <= bufferSize - offset) &&
+               "Mapped range exceeds the buffer.");
+        if (allocation.mapped == nullptr)
+        {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        mapped = static_cast<char *>(allocation.mapped) + offset;
+        return VK_SUCCESS;
     }
 
     void LveBuffer::unmap()
     {
-        if (mapped)
-        {
-            vkUnmapMemory(lveDevice.device(), memory);
-            mapped = nullptr;
-        }
+        mapped = nullptr;
     }
 
     void LveBuffer::writeToBuffer(const void *data, VkDeviceSize size, VkDeviceSize offset)
@@ -59,25 +63,135 @@ namespace lve
         if (size == VK_WHOLE_SIZE)
         {
             memcpy(mapped, data, bufferSize);
+            markDirty(bufferSize, 0);
         }
         else
         {
             char *memOffset{reinterpret_cast<char *>(mapped)};
             memOffset += offset;
             memcpy(memOffset, data, size);
+            markDirty(size, offset);
         }
     }
 
     VkResult LveBuffer::flush(VkDeviceSize size, VkDeviceSize offset)
     {
-        VkMappedMemoryRange mappedRange{};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        if (isCoherent())
+        {
+            return VK_SUCCESS;
+        }
+        clearDirty(size == VK_WHOLE_SIZE ? bufferSize - offset : size, offset);
+        VkMappedMemoryRange mappedRange{lveDevice.memoryAllocator().mappedRange(allocation, size, offset)};
         return vkFlushMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
     }
 
+    VkResult LveBuffer::commit()
+    {
+        if (dirtyRanges.empty())
+        {
+            return VK_SUCCESS;
+        }
+
+        // ranges arrive in write order, sorting lets overlapping and touching ones merge in one pass
+        std::sort(dirtyRanges.begin(), dirtyRanges.end(),
+                  [](const DirtyRange &a, const DirtyRange &b) { return a.begin < b.begin; });
+
+        std::vector<VkMappedMemoryRange> mappedRanges{};
+        DirtyRange merged{dirtyRanges[0]};
+        for (size_t i{1}; i <= dirtyRanges.size(); ++i)
+        {
+            if (i < dirtyRanges.size() && dirtyRanges[i].begin <= merged.end)
+            {
+                merged.end = std::max(merged.end, dirtyRanges[i].end);
+                continue;
+            }
+            mappedRanges.push_back(
+                lveDevice.memoryAllocator().mappedRange(allocation, merged.end - merged.begin, merged.begin));
+            if (i < dirtyRanges.size())
+            {
+                merged = dirtyRanges[i];
+            }
+        }
+        dirtyRanges.clear();
+
+        return vkFlushMappedMemoryRanges(
+            lveDevice.device(), static_cast<uint32_t>(mappedRanges.size()), mappedRanges.data());
+    }
+
+    // widened in memory space, as that is where flushes are aligned, then clamped back to the buffer
+    LveBuffer::DirtyRange LveBuffer::atomRange(VkDeviceSize size, VkDeviceSize offset) const
+    {
+        const VkDeviceSize atomSize{std::max<VkDeviceSize>(lveDevice.properties.limits.nonCoherentAtomSize, 1)};
+        VkDeviceSize begin{allocation.offset + offset};
+        VkDeviceSize end{begin + size};
+        begin -= begin % atomSize;
+        end = (end + atomSize - 1) / atomSize * atomSize;
+
+        DirtyRange range{};
+        range.begin = std::max(begin, allocation.offset) - allocation.offset;
+        range.end = std::min(end - allocation.offset, bufferSize);
+        return range;
+    }
+
+    void LveBuffer::markDirty(VkDeviceSize size, VkDeviceSize offset)
+    {
+        if (isCoherent() || size == 0)
+        {
+            return;
+        }
+
+        const DirtyRange range{atomRange(size, offset)};
+
+        // sequential writes, such as writeToIndex over consecutive instances, extend the last range
+        if (!dirtyRanges.empty() && range.begin <= dirtyRanges.back().end && range.end >= dirtyRanges.back().begin)
+        {
+            dirtyRanges.back().begin = std::min(dirtyRanges.back().begin, range.begin);
+            dirtyRanges.back().end = std::max(dirtyRanges.back().end, range.end);
+            return;
+        }
+        dirtyRanges.push_back(range);
+    }
+
+    // whatever a flush covered no longer needs committing, the parts of ranges outside it stay
+    void LveBuffer::clearDirty(VkDeviceSize size, VkDeviceSize offset)
+    {
+        const DirtyRange flushed{atomRange(size, offset)};
+        const VkDeviceSize begin{flushed.begin};
+        const VkDeviceSize end{flushed.end};
+        for (size_t i{0}; i < dirtyRanges.size();)
+        {
+            DirtyRange range{dirtyRanges[i]};
+            if (range.end <= begin || range.begin >= end)
+            {
+                ++i;
+                continue;
+            }
+
+            if (range.begin < begin && range.end > end)
+            {
+                dirtyRanges[i].end = begin;
+                dirtyRanges.push_back(DirtyRange{end, range.end});
+                ++i;
+            }
+            else if (range.begin < begin)
+            {
+                dirtyRanges[i].end = begin;
+                ++i;
+            }
+            else if (range.end > end)
+            {
+                dirtyRanges[i].begin = end;
+                ++i;
+            }
+            else
+            {
+                // order only matters to markDirty extending the last range, commit sorts anyway
+                dirtyRanges[i] = dirtyRanges.back();
+                dirtyRanges.pop_back();
+            }
+        }
+    }
+
     VkDescriptorBufferInfo LveBuffer::descriptorInfo(VkDeviceSize size, VkDeviceSize offset)
     {
         return {buffer, offset, size};
@@ -85,11 +199,7 @@ namespace lve
 
     VkResult LveBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset)
     {
-        VkMappedMemoryRange mappedRange{};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        VkMappedMemoryRange mappedRange{lveDevice.memoryAllocator().mappedRange(allocation, size, offset)};
         return vkInvalidateMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
     }
 
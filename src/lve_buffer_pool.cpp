@@ -0,0 +1,100 @@
+#include "lve_buffer_pool.hpp"
+
+#include <iterator>
+#include <vector>
+
+namespace lve
+{
+    LveBufferPool::LveBufferPool(VkDevice device, LveMemoryAllocator &allocator)
+        : device{device}, allocator{allocator}
+    {
+    }
+
+    LveBufferPool::~LveBufferPool() { clear(); }
+
+    bool LveBufferPool::acquire(
+        VkDeviceSize size,
+        VkBufferUsageFlags usage,
+        VkMemoryPropertyFlags properties,
+        VkBuffer &buffer,
+        LveAllocation &allocation)
+    {
+        if (size > MAX_BUFFER_SIZE)
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        // newest first, it is the most likely to still be in the caches
+        for (auto it{entries.rbegin()}; it != entries.rend(); ++it)
+        {
+            if (it->size == size && it->usage == usage && it->properties == properties)
+            {
+                buffer = it->buffer;
+                allocation = it->allocation;
+                pooledSize -= size;
+                entries.erase(std::next(it).base());
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void LveBufferPool::release(
+        VkDeviceSize size,
+        VkBufferUsageFlags usage,
+        VkMemoryPropertyFlags properties,
+        VkBuffer buffer,
+        LveAllocation allocation)
+    {
+        Entry entry{size, usage, properties, buffer, allocation};
+        if (size > MAX_BUFFER_SIZE)
+        {
+            destroy(entry);
+            return;
+        }
+
+        std::vector<Entry> evicted{};
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            entries.push_back(entry);
+            pooledSize += size;
+            while (pooledSize > CAPACITY)
+            {
+                pooledSize -= entries.front().size;
+                evicted.push_back(entries.front());
+                entries.pop_front();
+            }
+        }
+        for (auto &old : evicted)
+        {
+            destroy(old);
+        }
+    }
+
+    void LveBufferPool::clear()
+    {
+        std::deque<Entry> old{};
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            old.swap(entries);
+            pooledSize = 0;
+        }
+        for (auto &entry : old)
+        {
+            destroy(entry);
+        }
+    }
+
+    VkDeviceSize LveBufferPool::getPooledSize()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return pooledSize;
+    }
+
+    void LveBufferPool::destroy(Entry &entry)
+    {
+        vkDestroyBuffer(device, entry.buffer, nullptr);
+        allocator.free(entry.allocation);
+    }
+}
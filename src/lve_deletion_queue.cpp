@@ -0,0 +1,58 @@
+#include "lve_deletion_queue.hpp"
+
+namespace lve
+{
+    LveDeletionQueue::LveDeletionQueue(LveTimeline &frameTimeline) : frameTimeline{frameTimeline} {}
+
+    LveDeletionQueue::~LveDeletionQueue() { flush(); }
+
+    void LveDeletionQueue::push(std::function<void()> deleter)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        entries.push_back(Entry{frameTimeline.pendingValue(), std::move(deleter)});
+    }
+
+    void LveDeletionQueue::collect()
+    {
+        std::deque<Entry> ready{};
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (entries.empty() || !frameTimeline.isComplete(entries.front().frame))
+            {
+                return;
+            }
+            const uint64_t completedFrame{frameTimeline.getCompletedValue()};
+            while (!entries.empty() && entries.front().frame <= completedFrame)
+            {
+                ready.push_back(std::move(entries.front()));
+                entries.pop_front();
+            }
+        }
+        run(ready);
+    }
+
+    void LveDeletionQueue::flush()
+    {
+        while (true)
+        {
+            std::deque<Entry> ready{};
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                ready.swap(entries);
+            }
+            if (ready.empty())
+            {
+                return;
+            }
+            run(ready);
+        }
+    }
+
+    void LveDeletionQueue::run(std::deque<Entry> &ready)
+    {
+        for (auto &entry : ready)
+        {
+            entry.deleter();
+        }
+    }
+}
@@ -1,6 +1,7 @@
 #include "lve_device.hpp"
 
 // std headers
+#include <cassert>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -54,19 +55,29 @@ namespace lve
     }
 
     // class member functions
-    LveDevice::LveDevice(LveWindow &window) : window{window}
+    LveDevice::LveDevice(LveWindow *window) : window{window}
     {
         createInstance();
         setupDebugMessenger();
         createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
+        createMemoryAllocator();
+        createTimelines();
         createCommandPool();
     }
 
     LveDevice::~LveDevice()
     {
-        vkDestroyCommandPool(device_, commandPool, nullptr);
+        // deferred objects may still be in use and must go before the memory they live in
+        vkDeviceWaitIdle(device_);
+        deletionQueue_.reset();
+        // after the deletion queue, which releases buffers into the pool
+        bufferPool_.reset();
+        memoryAllocator_.reset();
+        graphicsTimeline_.reset();
+        transferTimeline_.reset();
+        vkDestroyCommandPool(device_, transferCommandPool, nullptr);
         vkDestroyDevice(device_, nullptr);
 
         if (enableValidationLayers)
@@ -91,13 +102,19 @@ namespace lve
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "No Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        appInfo.apiVersion = VK_API_VERSION_1_2;
 
         VkInstanceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
         createInfo.pApplicationInfo = &appInfo;
 
         auto extensions = getRequiredExtensions();
+        // optional, devices older than 1.1 need it to query VK_EXT_memory_budget
+        properties2Enabled = hasInstanceExtension(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        if (properties2Enabled)
+        {
+            extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        }
         createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
         createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -159,7 +176,7 @@ namespace lve
         QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+        std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily, indices.transferFamily};
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -175,15 +192,38 @@ namespace lve
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
 
+        // the same structure enables the core 1.2 feature and the extension's
+        VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures = {};
+        timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        timelineFeatures.timelineSemaphore = VK_TRUE;
+
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.pNext = &timelineFeatures;
 
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
+        std::vector<const char *> enabledExtensions{};
+        if (!isHeadless())
+        {
+            enabledExtensions = deviceExtensions;
+        }
+        memoryBudgetEnabled =
+            properties2Enabled && hasDeviceExtension(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (memoryBudgetEnabled)
+        {
+            enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+        timelineExtensionEnabled = properties.apiVersion < VK_API_VERSION_1_2;
+        if (timelineExtensionEnabled)
+        {
+            enabledExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+        }
+
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -204,6 +244,43 @@ namespace lve
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+        vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
+        std::cout << "transfer queue family: " << indices.transferFamily
+                  << (indices.hasDedicatedTransfer() ? " (dedicated)" : " (graphics)") << std::endl;
+    }
+
+    void LveDevice::createMemoryAllocator()
+    {
+        PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2{nullptr};
+        if (memoryBudgetEnabled)
+        {
+            getMemoryProperties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetInstanceProcAddr(
+                instance,
+                "vkGetPhysicalDeviceMemoryProperties2KHR");
+        }
+        std::cout << "memory budget: " << (getMemoryProperties2 ? "VK_EXT_memory_budget" : "heap sizes")
+                  << std::endl;
+
+        memoryAllocator_ = std::make_unique<LveMemoryAllocator>(physicalDevice, device_, getMemoryProperties2);
+        bufferPool_ = std::make_unique<LveBufferPool>(device_, *memoryAllocator_);
+    }
+
+    void LveDevice::createTimelines()
+    {
+        auto getCounterValue = (PFN_vkGetSemaphoreCounterValue)vkGetDeviceProcAddr(
+            device_,
+            timelineExtensionEnabled ? "vkGetSemaphoreCounterValueKHR" : "vkGetSemaphoreCounterValue");
+        auto waitSemaphores = (PFN_vkWaitSemaphores)vkGetDeviceProcAddr(
+            device_,
+            timelineExtensionEnabled ? "vkWaitSemaphoresKHR" : "vkWaitSemaphores");
+        if (getCounterValue == nullptr || waitSemaphores == nullptr)
+        {
+            throw std::runtime_error("failed to load timeline semaphore functions!");
+        }
+
+        graphicsTimeline_ = std::make_unique<LveTimeline>(device_, getCounterValue, waitSemaphores);
+        transferTimeline_ = std::make_unique<LveTimeline>(device_, getCounterValue, waitSemaphores);
+        deletionQueue_ = std::make_unique<LveDeletionQueue>(*graphicsTimeline_);
     }
 
     void LveDevice::createCommandPool()
@@ -213,16 +290,33 @@ namespace lve
         VkCommandPoolCreateInfo poolInfo = {};
         poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
         poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
-        poolInfo.flags =
-            VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
 
-        if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        if (vkCreateCommandPool(device_, &poolInfo, nullptr, &transferCommandPool) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create command pool!");
         }
+
+        // reused by every single time command, the pool reset recycles its memory
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = transferCommandPool;
+        allocInfo.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(device_, &allocInfo, &transferCommandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate transfer command buffer!");
+        }
     }
 
-    void LveDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+    void LveDevice::createSurface()
+    {
+        if (window != nullptr)
+        {
+            window->createWindowSurface(instance, &surface_);
+        }
+    }
 
     bool LveDevice::isDeviceSuitable(VkPhysicalDevice device)
     {
@@ -230,8 +324,9 @@ namespace lve
 
         bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported)
+        // headless rendering never presents
+        bool swapChainAdequate = isHeadless();
+        if (extensionsSupported && !isHeadless())
         {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -241,7 +336,7 @@ namespace lve
         vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
         return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-               supportedFeatures.samplerAnisotropy;
+               supportedFeatures.samplerAnisotropy && supportsTimelineSemaphores(device);
     }
 
     void LveDevice::populateDebugMessengerCreateInfo(
@@ -302,11 +397,15 @@ namespace lve
 
     std::vector<const char *> LveDevice::getRequiredExtensions()
     {
-        uint32_t glfwExtensionCount = 0;
-        const char **glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-        std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        std::vector<const char *> extensions{};
+        // GLFW is not even initialized when headless
+        if (!isHeadless())
+        {
+            uint32_t glfwExtensionCount = 0;
+            const char **glfwExtensions;
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
 
         if (enableValidationLayers)
         {
@@ -355,7 +454,11 @@ namespace lve
             &extensionCount,
             availableExtensions.data());
 
-        std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+        std::set<std::string> requiredExtensions{};
+        if (!isHeadless())
+        {
+            requiredExtensions.insert(deviceExtensions.begin(), deviceExtensions.end());
+        }
 
         for (const auto &extension : availableExtensions)
         {
@@ -365,6 +468,49 @@ namespace lve
         return requiredExtensions.empty();
     }
 
+    bool LveDevice::hasInstanceExtension(const char *name)
+    {
+        uint32_t extensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+        for (const auto &extension : extensions)
+        {
+            if (strcmp(name, extension.extensionName) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool LveDevice::hasDeviceExtension(VkPhysicalDevice device, const char *name)
+    {
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+
+        for (const auto &extension : extensions)
+        {
+            if (strcmp(name, extension.extensionName) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // both forms require the timelineSemaphore feature to be supported, so it needs no query
+    bool LveDevice::supportsTimelineSemaphores(VkPhysicalDevice device)
+    {
+        VkPhysicalDeviceProperties deviceProperties;
+        vkGetPhysicalDeviceProperties(device, &deviceProperties);
+        return deviceProperties.apiVersion >= VK_API_VERSION_1_2 ||
+               hasDeviceExtension(device, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+    }
+
     QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device)
     {
         QueueFamilyIndices indices;
@@ -378,19 +524,39 @@ namespace lve
         int i = 0;
         for (const auto &queueFamily : queueFamilies)
         {
-            if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+            if (!indices.isComplete())
             {
-                indices.graphicsFamily = i;
-                indices.graphicsFamilyHasValue = true;
+                if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+                {
+                    indices.graphicsFamily = i;
+                    indices.graphicsFamilyHasValue = true;
+                }
+                VkBool32 presentSupport = false;
+                if (isHeadless())
+                {
+                    // nothing is presented, the graphics family stands in for the present family
+                    presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+                }
+                else
+                {
+                    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+                }
+                if (queueFamily.queueCount > 0 && presentSupport)
+                {
+                    indices.presentFamily = i;
+                    indices.presentFamilyHasValue = true;
+                }
             }
-            VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-            if (queueFamily.queueCount > 0 && presentSupport)
+            // graphics and compute families support transfers too, only a family without them is
+            // the copy engine that runs alongside rendering
+            if (queueFamily.queueCount > 0 && !indices.transferFamilyHasValue &&
+                (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+                !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
             {
-                indices.presentFamily = i;
-                indices.presentFamilyHasValue = true;
+                indices.transferFamily = i;
+                indices.transferFamilyHasValue = true;
             }
-            if (indices.isComplete())
+            if (indices.isComplete() && indices.transferFamilyHasValue)
             {
                 break;
             }
@@ -398,6 +564,12 @@ namespace lve
             i++;
         }
 
+        if (!indices.transferFamilyHasValue && indices.graphicsFamilyHasValue)
+        {
+            indices.transferFamily = indices.graphicsFamily;
+            indices.transferFamilyHasValue = true;
+        }
+
         return indices;
     }
 
@@ -472,8 +644,13 @@ namespace lve
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer &buffer,
-        VkDeviceMemory &bufferMemory)
+        LveAllocation &allocation)
     {
+        if (bufferPool_->acquire(size, usage, properties, buffer, allocation))
+        {
+            return;
+        }
+
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferInfo.size = size;
@@ -488,36 +665,57 @@ namespace lve
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        // accounting only, host visible buffers used for transfers count as staging
+        LveMemoryCategory category{LveMemoryCategory::Other};
+        if ((properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) &&
+            (usage & (VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)))
+        {
+            category = LveMemoryCategory::Staging;
+        }
+        else if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT))
+        {
+            category = LveMemoryCategory::Geometry;
+        }
+        else if (usage & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT))
+        {
+            category = LveMemoryCategory::Uniform;
+        }
+
+        allocation = memoryAllocator_->allocate(
+            memRequirements, findMemoryType(memRequirements.memoryTypeBits, properties), true, category);
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+        if (vkBindBufferMemory(device_, buffer, allocation.memory, allocation.offset) != VK_SUCCESS)
         {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
+            throw std::runtime_error("failed to bind buffer memory!");
         }
+    }
 
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+    void LveDevice::destroyBuffer(
+        VkDeviceSize size,
+        VkBufferUsageFlags usage,
+        VkMemoryPropertyFlags properties,
+        VkBuffer buffer,
+        LveAllocation allocation)
+    {
+        deletionQueue_->push(
+            [this, size, usage, properties, buffer, allocation]()
+            { bufferPool_->release(size, usage, properties, buffer, allocation); });
     }
 
     VkCommandBuffer LveDevice::beginSingleTimeCommands()
     {
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = commandPool;
-        allocInfo.commandBufferCount = 1;
+        assert(!singleTimeCommandsActive && "Single time commands are already being recorded.");
+        singleTimeCommandsActive = true;
 
-        VkCommandBuffer commandBuffer;
-        vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
+        // the previous submission was waited on, so the pool is free to reset
+        vkResetCommandPool(device_, transferCommandPool, 0);
 
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-        vkBeginCommandBuffer(commandBuffer, &beginInfo);
-        return commandBuffer;
+        vkBeginCommandBuffer(transferCommandBuffer, &beginInfo);
+        return transferCommandBuffer;
     }
 
     void LveDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer)
@@ -532,16 +730,17 @@ namespace lve
         vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
         vkQueueWaitIdle(graphicsQueue_);
 
-        vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+        singleTimeCommandsActive = false;
     }
 
-    void LveDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+    void LveDevice::copyBuffer(
+        VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset)
     {
         VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
         VkBufferCopy copyRegion{};
-        copyRegion.srcOffset = 0; // Optional
-        copyRegion.dstOffset = 0; // Optional
+        copyRegion.srcOffset = srcOffset;
+        copyRegion.dstOffset = dstOffset;
         copyRegion.size = size;
         vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
@@ -580,7 +779,7 @@ namespace lve
         const VkImageCreateInfo &imageInfo,
         VkMemoryPropertyFlags properties,
         VkImage &image,
-        VkDeviceMemory &imageMemory)
+        LveAllocation &allocation)
     {
         if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS)
         {
@@ -590,17 +789,13 @@ namespace lve
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
+        allocation = memoryAllocator_->allocate(
+            memRequirements,
+            findMemoryType(memRequirements.memoryTypeBits, properties),
+            imageInfo.tiling == VK_IMAGE_TILING_LINEAR,
+            LveMemoryCategory::Image);
 
-        if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS)
+        if (vkBindImageMemory(device_, image, allocation.memory, allocation.offset) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to bind image memory!");
         }
@@ -0,0 +1,252 @@
+#include "lve_frame_readback.hpp"
+
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve
+{
+    namespace
+    {
+        bool hasStencil(VkFormat format)
+        {
+            return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT ||
+                   format == VK_FORMAT_D16_UNORM_S8_UINT;
+        }
+    }
+
+    LveFrameReadback::LveFrameReadback(LveDevice &device, LveRenderer &renderer, uint32_t slotCount)
+        : lveDevice{device}, lveRenderer{renderer}, slots(slotCount)
+    {
+        assert(slotCount > 0 && "Frame readback needs at least one slot.");
+    }
+
+    bool LveFrameReadback::capture(VkCommandBuffer commandBuffer, Callback callback, bool withDepth)
+    {
+        LveSwapChain &swapChain{lveRenderer.getSwapChain()};
+        if (!swapChain.isColorReadable())
+        {
+            throw std::runtime_error("Swap chain images cannot be read back on this surface.");
+        }
+        assert((!withDepth || swapChain.isDepthReadable()) && "Depth readback needs readableDepth frame setting.");
+
+        if (pendingCount == slots.size())
+        {
+            ++droppedCount;
+            return false;
+        }
+
+        const VkFormat colorFormat{swapChain.getSwapChainImageFormat()};
+        const VkFormat depthFormat{withDepth ? swapChain.getSwapChainDepthFormat() : VK_FORMAT_UNDEFINED};
+        if (texelSize(colorFormat) == 0 || (withDepth && texelSize(depthFormat) == 0))
+        {
+            throw std::runtime_error("Swap chain format cannot be read back.");
+        }
+
+        Slot &slot{slots[(oldestSlot + pendingCount) % slots.size()]};
+        slot.frame = LveReadbackFrame{};
+        slot.frame.frameNumber = lveRenderer.getFrameNumber();
+        slot.frame.extent = lveRenderer.getSwapChainExtent();
+        slot.frame.colorFormat = colorFormat;
+        slot.frame.depthFormat = depthFormat;
+        slot.callback = std::move(callback);
+        prepareSlot(slot, slot.frame.extent);
+        const VkExtent2D extent{slot.frame.extent};
+
+        const VkImageAspectFlags depthAspects{
+            VK_IMAGE_ASPECT_DEPTH_BIT |
+            (hasStencil(depthFormat) ? VkImageAspectFlags{VK_IMAGE_ASPECT_STENCIL_BIT} : VkImageAspectFlags{0})};
+
+        // both images go to TRANSFER_SRC in one barrier, and back in another along with making the
+        // copies visible to the host
+        std::array<VkImageMemoryBarrier, 2> toTransfer{};
+        toTransfer[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        toTransfer[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        toTransfer[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        toTransfer[0].oldLayout = swapChain.getFinalLayout();
+        toTransfer[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        toTransfer[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toTransfer[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toTransfer[0].image = lveRenderer.getCurrentImage();
+        toTransfer[0].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+        toTransfer[1] = toTransfer[0];
+        toTransfer[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        toTransfer[1].oldLayout = swapChain.getFinalDepthLayout();
+        toTransfer[1].image = lveRenderer.getCurrentDepthImage();
+        toTransfer[1].subresourceRange = {depthAspects, 0, 1, 0, 1};
+
+        const uint32_t imageCount{withDepth ? 2u : 1u};
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            imageCount,
+            toTransfer.data());
+
+        VkBufferImageCopy region{};
+        region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        region.imageExtent = {extent.width, extent.height, 1};
+        vkCmdCopyImageToBuffer(
+            commandBuffer,
+            toTransfer[0].image,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            slot.colorBuffer->getBuffer(),
+            1,
+            &region);
+        if (withDepth)
+        {
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+            vkCmdCopyImageToBuffer(
+                commandBuffer,
+                toTransfer[1].image,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                slot.depthBuffer->getBuffer(),
+                1,
+                &region);
+        }
+
+        std::array<VkImageMemoryBarrier, 2> toFinal{toTransfer};
+        for (uint32_t i{0}; i < imageCount; ++i)
+        {
+            std::swap(toFinal[i].oldLayout, toFinal[i].newLayout);
+            // the copy only read the image, the transition just has to wait for it
+            toFinal[i].srcAccessMask = 0;
+            toFinal[i].dstAccessMask = 0;
+        }
+
+        std::array<VkBufferMemoryBarrier, 2> toHost{};
+        toHost[0].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        toHost[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        toHost[0].dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        toHost[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toHost[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toHost[0].buffer = slot.colorBuffer->getBuffer();
+        toHost[0].size = VK_WHOLE_SIZE;
+        if (withDepth)
+        {
+            toHost[1] = toHost[0];
+            toHost[1].buffer = slot.depthBuffer->getBuffer();
+        }
+
+        // presentation waits for the whole submission, so no later stage needs to wait for the
+        // transition back
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_HOST_BIT,
+            0,
+            0,
+            nullptr,
+            imageCount,
+            toHost.data(),
+            imageCount,
+            toFinal.data());
+
+        ++pendingCount;
+        return true;
+    }
+
+    void LveFrameReadback::update()
+    {
+        LveTimeline &timeline{lveDevice.graphicsTimeline()};
+        while (pendingCount > 0 && timeline.isComplete(slots[oldestSlot].frame.frameNumber))
+        {
+            deliver(slots[oldestSlot]);
+        }
+    }
+
+    void LveFrameReadback::flush()
+    {
+        LveTimeline &timeline{lveDevice.graphicsTimeline()};
+        while (pendingCount > 0)
+        {
+            timeline.wait(slots[oldestSlot].frame.frameNumber);
+            deliver(slots[oldestSlot]);
+        }
+    }
+
+    uint32_t LveFrameReadback::texelSize(VkFormat format)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_R5G6B5_UNORM_PACK16:
+        case VK_FORMAT_B5G6R5_UNORM_PACK16:
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+            return 2;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+        case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+        case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+        case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+        case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+        // the depth aspect of packed 24 bit formats is copied as 32 bit texels
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return 4;
+        case VK_FORMAT_R16G16B16A16_UNORM:
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+            return 8;
+        default:
+            return 0;
+        }
+    }
+
+    void LveFrameReadback::prepareSlot(Slot &slot, VkExtent2D extent)
+    {
+        const uint32_t texelCount{extent.width * extent.height};
+        auto createBuffer = [&](VkFormat format)
+        {
+            auto buffer{std::make_unique<LveBuffer>(
+                lveDevice,
+                texelSize(format),
+                texelCount,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)};
+            buffer->map();
+            return buffer;
+        };
+        auto fits = [&](const std::unique_ptr<LveBuffer> &buffer, VkFormat format)
+        {
+            return buffer != nullptr && buffer->getInstanceCount() == texelCount &&
+                   buffer->getInstanceSize() == texelSize(format);
+        };
+
+        // the old buffers are released once their frames have completed, so replacing them here
+        // is safe
+        if (!fits(slot.colorBuffer, slot.frame.colorFormat))
+        {
+            slot.colorBuffer = createBuffer(slot.frame.colorFormat);
+        }
+        if (slot.frame.depthFormat != VK_FORMAT_UNDEFINED && !fits(slot.depthBuffer, slot.frame.depthFormat))
+        {
+            slot.depthBuffer = createBuffer(slot.frame.depthFormat);
+        }
+    }
+
+    void LveFrameReadback::deliver(Slot &slot)
+    {
+        slot.frame.color = slot.colorBuffer->getMappedMemory();
+        slot.frame.depth =
+            slot.frame.depthFormat != VK_FORMAT_UNDEFINED ? slot.depthBuffer->getMappedMemory() : nullptr;
+
+        if (slot.callback)
+        {
+            slot.callback(slot.frame);
+            slot.callback = nullptr;
+        }
+        oldestSlot = static_cast<uint32_t>((oldestSlot + 1) % slots.size());
+        --pendingCount;
+    }
+}
@@ -0,0 +1,81 @@
+#include "lve_frame_ring_buffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve
+{
+    LveFrameRingBuffer::LveFrameRingBuffer(
+        LveDevice &device, VkDeviceSize capacityPerFrame, uint32_t frameCount, VkBufferUsageFlags usage)
+        : frameCount{frameCount}
+    {
+        const VkPhysicalDeviceLimits &limits{device.properties.limits};
+        alignment = std::max<VkDeviceSize>(alignment, limits.nonCoherentAtomSize);
+        if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+        {
+            alignment = std::max(alignment, limits.minUniformBufferOffsetAlignment);
+        }
+        if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+        {
+            alignment = std::max(alignment, limits.minStorageBufferOffsetAlignment);
+        }
+
+        // whole regions keep every frame start aligned
+        frameCapacity = (capacityPerFrame + alignment - 1) / alignment * alignment;
+
+        buffer = std::make_unique<LveBuffer>(
+            device, frameCapacity, frameCount, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        if (buffer->map() != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to map frame ring buffer.");
+        }
+    }
+
+    void LveFrameRingBuffer::beginFrame(uint32_t frameIndex)
+    {
+        assert(!frameStarted && "Previous frame was not ended.");
+        assert(frameIndex < frameCount && "Frame index out of range.");
+
+        frameStart = frameCapacity * frameIndex;
+        cursor = frameStart;
+        frameStarted = true;
+    }
+
+    LveFrameAllocation LveFrameRingBuffer::allocate(VkDeviceSize size)
+    {
+        assert(frameStarted && "Cannot allocate outside of a frame.");
+
+        if (size > frameStart + frameCapacity - cursor)
+        {
+            throw std::runtime_error("Frame ring buffer out of space.");
+        }
+
+        LveFrameAllocation allocation{};
+        allocation.data = static_cast<char *>(buffer->getMappedMemory()) + cursor;
+        allocation.dynamicOffset = static_cast<uint32_t>(cursor);
+        cursor = std::min(frameStart + frameCapacity, (cursor + size + alignment - 1) / alignment * alignment);
+        return allocation;
+    }
+
+    LveFrameAllocation LveFrameRingBuffer::write(const void *data, VkDeviceSize size)
+    {
+        LveFrameAllocation allocation{allocate(size)};
+        std::memcpy(allocation.data, data, static_cast<size_t>(size));
+        return allocation;
+    }
+
+    void LveFrameRingBuffer::endFrame()
+    {
+        assert(frameStarted && "Cannot end a frame that was not started.");
+
+        // allocations are written through their pointers, so the frame's region is marked as a whole
+        if (cursor > frameStart)
+        {
+            buffer->markDirty(cursor - frameStart, frameStart);
+            buffer->commit();
+        }
+        frameStarted = false;
+    }
+}
@@ -0,0 +1,248 @@
+#include "lve_frame_writer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace lve
+{
+    namespace
+    {
+        bool isBgra(VkFormat format)
+        {
+            return format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_B8G8R8A8_UNORM;
+        }
+
+        bool isRgba(VkFormat format)
+        {
+            return format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_R8G8B8A8_UNORM;
+        }
+
+        uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0)
+        {
+            static const std::array<uint32_t, 256> table = []()
+            {
+                std::array<uint32_t, 256> table{};
+                for (uint32_t i{0}; i < 256; ++i)
+                {
+                    uint32_t value{i};
+                    for (int bit{0}; bit < 8; ++bit)
+                    {
+                        value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+                    }
+                    table[i] = value;
+                }
+                return table;
+            }();
+
+            crc = ~crc;
+            for (size_t i{0}; i < size; ++i)
+            {
+                crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+            }
+            return ~crc;
+        }
+
+        void appendBigEndian(std::vector<uint8_t> &out, uint32_t value)
+        {
+            out.push_back(static_cast<uint8_t>(value >> 24));
+            out.push_back(static_cast<uint8_t>(value >> 16));
+            out.push_back(static_cast<uint8_t>(value >> 8));
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        void appendChunk(std::vector<uint8_t> &out, const char *type, const std::vector<uint8_t> &data)
+        {
+            appendBigEndian(out, static_cast<uint32_t>(data.size()));
+            const size_t typeStart{out.size()};
+            out.insert(out.end(), type, type + 4);
+            out.insert(out.end(), data.begin(), data.end());
+            appendBigEndian(out, crc32(out.data() + typeStart, out.size() - typeStart));
+        }
+
+        // stored deflate blocks, frames are written often and rarely kept, so speed beats size
+        std::vector<uint8_t> encodePng(VkExtent2D extent, VkFormat format, const std::vector<uint8_t> &texels)
+        {
+            const size_t rowSize{1 + 3 * static_cast<size_t>(extent.width)};
+            std::vector<uint8_t> scanlines(rowSize * extent.height);
+            const int red{isBgra(format) ? 2 : 0};
+            const int blue{isBgra(format) ? 0 : 2};
+            for (uint32_t y{0}; y < extent.height; ++y)
+            {
+                uint8_t *row{scanlines.data() + y * rowSize};
+                // filter type none
+                *row++ = 0;
+                const uint8_t *texel{texels.data() + 4 * static_cast<size_t>(y) * extent.width};
+                for (uint32_t x{0}; x < extent.width; ++x, texel += 4)
+                {
+                    *row++ = texel[red];
+                    *row++ = texel[1];
+                    *row++ = texel[blue];
+                }
+            }
+
+            std::vector<uint8_t> zlib{0x78, 0x01};
+            size_t offset{0};
+            do
+            {
+                const size_t size{std::min<size_t>(scanlines.size() - offset, 0xFFFF)};
+                const bool last{offset + size == scanlines.size()};
+                zlib.push_back(last ? 1 : 0);
+                zlib.push_back(static_cast<uint8_t>(size));
+                zlib.push_back(static_cast<uint8_t>(size >> 8));
+                zlib.push_back(static_cast<uint8_t>(~size));
+                zlib.push_back(static_cast<uint8_t>(~size >> 8));
+                zlib.insert(zlib.end(), scanlines.begin() + offset, scanlines.begin() + offset + size);
+                offset += size;
+            } while (offset < scanlines.size());
+
+            uint32_t a{1};
+            uint32_t b{0};
+            for (uint8_t value : scanlines)
+            {
+                a = (a + value) % 65521;
+                b = (b + a) % 65521;
+            }
+            appendBigEndian(zlib, (b << 16) | a);
+
+            std::vector<uint8_t> header{};
+            appendBigEndian(header, extent.width);
+            appendBigEndian(header, extent.height);
+            // 8 bit RGB, default compression, filtering and no interlacing
+            header.insert(header.end(), {8, 2, 0, 0, 0});
+
+            std::vector<uint8_t> png{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+            appendChunk(png, "IHDR", header);
+            appendChunk(png, "IDAT", zlib);
+            appendChunk(png, "IEND", {});
+            return png;
+        }
+
+        void writeFile(const std::string &path, const std::vector<uint8_t> &data)
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file)
+            {
+                throw std::runtime_error("Failed to write frame file: " + path);
+            }
+        }
+    }
+
+    LveFrameWriter::LveFrameWriter(const std::string &directory, LveFrameFileFormat format, uint32_t maxQueued)
+        : directory{directory}, format{format}, maxQueued{std::max(maxQueued, 1u)}
+    {
+        std::error_code error{};
+        std::filesystem::create_directories(directory, error);
+        if (error)
+        {
+            throw std::runtime_error("Failed to create frame directory: " + directory);
+        }
+        worker = std::thread{&LveFrameWriter::workerLoop, this};
+    }
+
+    LveFrameWriter::~LveFrameWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stopping = true;
+        }
+        jobCondition.notify_all();
+        worker.join();
+    }
+
+    void LveFrameWriter::write(const LveReadbackFrame &frame)
+    {
+        if (format == LveFrameFileFormat::Png && !isBgra(frame.colorFormat) && !isRgba(frame.colorFormat))
+        {
+            throw std::runtime_error("PNG frames need an 8 bit RGBA or BGRA color format.");
+        }
+
+        // copied outside the lock, the worker keeps going meanwhile
+        const size_t texelCount{static_cast<size_t>(frame.extent.width) * frame.extent.height};
+        Job job{};
+        job.frameNumber = frame.frameNumber;
+        job.extent = frame.extent;
+        job.colorFormat = frame.colorFormat;
+        const auto *color{static_cast<const uint8_t *>(frame.color)};
+        job.color.assign(color, color + texelCount * LveFrameReadback::texelSize(frame.colorFormat));
+        if (frame.depth != nullptr)
+        {
+            const auto *depth{static_cast<const uint8_t *>(frame.depth)};
+            job.depth.assign(depth, depth + texelCount * LveFrameReadback::texelSize(frame.depthFormat));
+        }
+
+        std::unique_lock<std::mutex> lock{mutex};
+        spaceCondition.wait(lock, [this]() { return jobs.size() < maxQueued || error; });
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        jobs.push_back(std::move(job));
+        jobCondition.notify_one();
+    }
+
+    uint64_t LveFrameWriter::getWrittenCount()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return writtenCount;
+    }
+
+    void LveFrameWriter::workerLoop()
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        while (true)
+        {
+            jobCondition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (jobs.empty())
+            {
+                return;
+            }
+
+            Job job{std::move(jobs.front())};
+            jobs.pop_front();
+            spaceCondition.notify_one();
+
+            lock.unlock();
+            try
+            {
+                writeJob(job);
+            }
+            catch (...)
+            {
+                lock.lock();
+                error = std::current_exception();
+                // a failing disk fails every frame, so the rest is dropped
+                jobs.clear();
+                spaceCondition.notify_all();
+                return;
+            }
+            lock.lock();
+            ++writtenCount;
+        }
+    }
+
+    void LveFrameWriter::writeJob(const Job &job)
+    {
+        std::ostringstream name{};
+        name << "frame_" << std::setw(6) << std::setfill('0') << job.frameNumber;
+        const std::string path{(std::filesystem::path{directory} / name.str()).string()};
+
+        if (format == LveFrameFileFormat::Png)
+        {
+            writeFile(path + ".png", encodePng(job.extent, job.colorFormat, job.color));
+        }
+        else
+        {
+            writeFile(path + ".raw", job.color);
+        }
+        if (!job.depth.empty())
+        {
+            writeFile(path + "_depth.raw", job.depth);
+        }
+    }
+}
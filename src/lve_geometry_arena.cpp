@@ -0,0 +1,180 @@
+#include "lve_geometry_arena.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+namespace lve
+{
+    LveGeometryArena::LveGeometryArena(LveDevice &device, LveUploadBatcher &uploadBatcher)
+        : lveDevice{device}, uploadBatcher{uploadBatcher}
+    {
+    }
+
+    LveGeometryArena::~LveGeometryArena()
+    {
+        // pending copies must not target destroyed blocks, and deferred frees of models destroyed
+        // earlier must run while the arena is alive
+        uploadBatcher.waitIdle();
+        vkDeviceWaitIdle(lveDevice.device());
+        lveDevice.deletionQueue().flush();
+    }
+
+    LveGeometryAllocation LveGeometryArena::allocateVertices(const void *data, uint32_t vertexSize, uint32_t count)
+    {
+        return allocate(
+            data,
+            static_cast<VkDeviceSize>(vertexSize) * count,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            vertexSize,
+            VERTEX_BLOCK_SIZE);
+    }
+
+    LveGeometryAllocation LveGeometryArena::allocateIndices(const void *data, uint32_t indexSize, uint32_t count)
+    {
+        assert(INDEX_UNIT_SIZE % indexSize == 0 && "Index size must divide the index unit size.");
+        return allocate(
+            data,
+            static_cast<VkDeviceSize>(indexSize) * count,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            INDEX_UNIT_SIZE,
+            INDEX_BLOCK_SIZE);
+    }
+
+    LveGeometryAllocation LveGeometryArena::allocate(
+        const void *data, VkDeviceSize size, VkBufferUsageFlags usage, VkDeviceSize unitSize, VkDeviceSize blockSize)
+    {
+        assert(size > 0 && "Cannot allocate empty geometry.");
+
+        const VkDeviceSize units{(size + unitSize - 1) / unitSize};
+
+        LveGeometryAllocation allocation{};
+        uint64_t unitOffset{0};
+        for (uint32_t i{0}; i < blocks.size() && !allocation.isValid(); ++i)
+        {
+            Block &block{blocks[i]};
+            if (!block.buffer || block.usage != usage || block.unitSize != unitSize)
+            {
+                continue;
+            }
+            uint32_t node{block.allocator.allocate(units, unitOffset)};
+            if (node != LveTlsfAllocator::INVALID_NODE)
+            {
+                allocation.block = i;
+                allocation.node = node;
+            }
+        }
+
+        if (!allocation.isValid())
+        {
+            // oversized meshes get a block of their own
+            const VkDeviceSize blockUnits{std::max(blockSize / unitSize, units)};
+            Block block{
+                std::make_unique<LveBuffer>(
+                    lveDevice,
+                    unitSize,
+                    static_cast<uint32_t>(blockUnits),
+                    usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+                LveTlsfAllocator{blockUnits},
+                usage,
+                unitSize};
+
+            auto freeSlot{std::find_if(blocks.begin(), blocks.end(), [](const Block &b) { return !b.buffer; })};
+            allocation.block = static_cast<uint32_t>(freeSlot - blocks.begin());
+            if (freeSlot != blocks.end())
+            {
+                *freeSlot = std::move(block);
+            }
+            else
+            {
+                blocks.push_back(std::move(block));
+            }
+            std::cout << "Geometry arena block " << allocation.block << ": "
+                      << blockUnits * unitSize / (1024.f * 1024.f) << " MB\n";
+
+            allocation.node = blocks[allocation.block].allocator.allocate(units, unitOffset);
+            assert(allocation.node != LveTlsfAllocator::INVALID_NODE && "New block must fit the allocation.");
+        }
+        allocation.offset = unitOffset * unitSize;
+        allocation.upload = uploadBatcher.upload(
+            blocks[allocation.block].buffer->getBuffer(), allocation.offset, data, size);
+        return allocation;
+    }
+
+    void LveGeometryArena::free(LveGeometryAllocation &allocation)
+    {
+        if (!allocation.isValid())
+        {
+            return;
+        }
+        assert(allocation.block < blocks.size() && "Allocation does not belong to this arena.");
+        blocks[allocation.block].allocator.free(allocation.node);
+        allocation = LveGeometryAllocation{};
+    }
+
+    void LveGeometryArena::readBack(const LveGeometryAllocation &allocation, void *data, VkDeviceSize size)
+    {
+        assert(allocation.isValid() && allocation.block < blocks.size() && "Allocation does not belong to this arena.");
+        uploadBatcher.wait(allocation.upload);
+
+        LveBuffer readbackBuffer{
+            lveDevice,
+            size,
+            1,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT};
+        lveDevice.copyBuffer(
+            blocks[allocation.block].buffer->getBuffer(), readbackBuffer.getBuffer(), size, allocation.offset, 0);
+
+        readbackBuffer.map();
+        readbackBuffer.invalidate();
+        std::memcpy(data, readbackBuffer.getMappedMemory(), static_cast<size_t>(size));
+    }
+
+    void LveGeometryArena::trim()
+    {
+        for (uint32_t i{0}; i < blocks.size(); ++i)
+        {
+            Block &block{blocks[i]};
+            if (block.buffer && block.allocator.getFreeSize() == block.allocator.getCapacity())
+            {
+                std::cout << "Geometry arena block " << i << " released\n";
+                block.buffer.reset();
+            }
+        }
+    }
+
+    VkDeviceSize LveGeometryArena::getReservedSize() const
+    {
+        VkDeviceSize size{0};
+        for (const auto &block : blocks)
+        {
+            if (block.buffer)
+            {
+                size += block.allocator.getCapacity() * block.unitSize;
+            }
+        }
+        return size;
+    }
+
+    VkDeviceSize LveGeometryArena::getUsedSize() const
+    {
+        VkDeviceSize size{0};
+        for (const auto &block : blocks)
+        {
+            if (block.buffer)
+            {
+                size += (block.allocator.getCapacity() - block.allocator.getFreeSize()) * block.unitSize;
+            }
+        }
+        return size;
+    }
+
+    VkBuffer LveGeometryArena::getBuffer(const LveGeometryAllocation &allocation) const
+    {
+        assert(allocation.block < blocks.size() && "Allocation does not belong to this arena.");
+        return blocks[allocation.block].buffer->getBuffer();
+    }
+}
@@ -0,0 +1,120 @@
+#include "lve_mapped_file.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <stdexcept>
+
+namespace lve
+{
+#ifdef _WIN32
+    LveMappedFile::LveMappedFile(const std::string &filePath)
+    {
+        HANDLE file{CreateFileA(
+            filePath.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+            nullptr)};
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("Failed to open file: " + filePath + ".");
+        }
+        fileHandle = file;
+
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file, &size))
+        {
+            CloseHandle(file);
+            throw std::runtime_error("Failed to query size of file: " + filePath + ".");
+        }
+        fileSize = static_cast<size_t>(size.QuadPart);
+
+        // zero-length files cannot be mapped, leave data() as nullptr
+        if (fileSize == 0)
+        {
+            return;
+        }
+
+        HANDLE mapping{CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+        if (mapping == nullptr)
+        {
+            CloseHandle(file);
+            throw std::runtime_error("Failed to map file: " + filePath + ".");
+        }
+        mappingHandle = mapping;
+
+        mapped = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (mapped == nullptr)
+        {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            throw std::runtime_error("Failed to map file: " + filePath + ".");
+        }
+    }
+
+    LveMappedFile::~LveMappedFile()
+    {
+        if (mapped)
+        {
+            UnmapViewOfFile(mapped);
+        }
+        if (mappingHandle)
+        {
+            CloseHandle(mappingHandle);
+        }
+        CloseHandle(fileHandle);
+    }
+#else
+    LveMappedFile::LveMappedFile(const std::string &filePath)
+    {
+        fileDescriptor = open(filePath.c_str(), O_RDONLY);
+        if (fileDescriptor < 0)
+        {
+            throw std::runtime_error("Failed to open file: " + filePath + ".");
+        }
+
+        struct stat fileStat{};
+        if (fstat(fileDescriptor, &fileStat) != 0)
+        {
+            close(fileDescriptor);
+            throw std::runtime_error("Failed to query size of file: " + filePath + ".");
+        }
+        fileSize = static_cast<size_t>(fileStat.st_size);
+
+        // zero-length files cannot be mapped, leave data() as nullptr
+        if (fileSize == 0)
+        {
+            return;
+        }
+
+        void *view{mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0)};
+        if (view == MAP_FAILED)
+        {
+            close(fileDescriptor);
+            throw std::runtime_error("Failed to map file: " + filePath + ".");
+        }
+        madvise(view, fileSize, MADV_SEQUENTIAL);
+        mapped = static_cast<const char *>(view);
+    }
+
+    LveMappedFile::~LveMappedFile()
+    {
+        if (mapped)
+        {
+            munmap(const_cast<char *>(mapped), fileSize);
+        }
+        close(fileDescriptor);
+    }
+#endif
+}
@@ -0,0 +1,287 @@
+#include "lve_memory_allocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve
+{
+    LveMemoryAllocator::LveMemoryAllocator(
+        VkPhysicalDevice physicalDevice,
+        VkDevice device,
+        PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2)
+        : physicalDevice{physicalDevice}, device{device}, getMemoryProperties2{getMemoryProperties2}
+    {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+        VkPhysicalDeviceProperties properties{};
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+    }
+
+    LveMemoryAllocator::~LveMemoryAllocator()
+    {
+        for (auto &block : blocks)
+        {
+            assert(block.allocationCount == 0 && "Memory block freed while still in use.");
+            if (block.memory != VK_NULL_HANDLE)
+            {
+                freeMemory(block.memoryTypeIndex, block.size, block.memory, block.mapped);
+            }
+        }
+        assert(dedicatedCount == 0 && "Dedicated allocation leaked.");
+    }
+
+    LveAllocation LveMemoryAllocator::allocate(
+        const VkMemoryRequirements &requirements,
+        uint32_t memoryTypeIndex,
+        bool linear,
+        LveMemoryCategory category)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        LveAllocation allocation{};
+        allocation.size = requirements.size;
+        allocation.propertyFlags = memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+        allocation.memoryTypeIndex = memoryTypeIndex;
+        allocation.category = category;
+
+        const VkDeviceSize blockSize{preferredBlockSize(memoryTypeIndex)};
+        if (requirements.size > blockSize / 2)
+        {
+            if (!allocateMemory(memoryTypeIndex, requirements.size, allocation.memory, allocation.mapped))
+            {
+                throw std::runtime_error("Failed to allocate dedicated device memory.");
+            }
+            ++dedicatedCount;
+            dedicatedBytes += requirements.size;
+            categoryBytes[static_cast<size_t>(category)] += requirements.size;
+            return allocation;
+        }
+
+        uint64_t offset{0};
+        for (uint32_t i{0}; i < blocks.size() && allocation.block == LveTlsfAllocator::INVALID_NODE; ++i)
+        {
+            Block &block{blocks[i]};
+            if (block.memory == VK_NULL_HANDLE || block.memoryTypeIndex != memoryTypeIndex || block.linear != linear)
+            {
+                continue;
+            }
+            uint32_t node{block.allocator.allocate(requirements.size, offset, requirements.alignment)};
+            if (node != LveTlsfAllocator::INVALID_NODE)
+            {
+                allocation.block = i;
+                allocation.node = node;
+            }
+        }
+
+        if (allocation.block == LveTlsfAllocator::INVALID_NODE)
+        {
+            Block block{};
+            block.size = blockSize;
+            block.memoryTypeIndex = memoryTypeIndex;
+            block.linear = linear;
+            if (!allocateMemory(memoryTypeIndex, block.size, block.memory, block.mapped))
+            {
+                throw std::runtime_error("Failed to allocate device memory block.");
+            }
+            block.allocator = LveTlsfAllocator{block.size};
+
+            if (!unusedBlocks.empty())
+            {
+                allocation.block = unusedBlocks.back();
+                unusedBlocks.pop_back();
+                blocks[allocation.block] = std::move(block);
+            }
+            else
+            {
+                allocation.block = static_cast<uint32_t>(blocks.size());
+                blocks.push_back(std::move(block));
+            }
+
+            allocation.node = blocks[allocation.block].allocator.allocate(
+                requirements.size, offset, requirements.alignment);
+            assert(allocation.node != LveTlsfAllocator::INVALID_NODE && "New block must fit the allocation.");
+        }
+
+        Block &block{blocks[allocation.block]};
+        ++block.allocationCount;
+        categoryBytes[static_cast<size_t>(category)] += requirements.size;
+        allocation.memory = block.memory;
+        allocation.offset = offset;
+        if (block.mapped != nullptr)
+        {
+            allocation.mapped = static_cast<char *>(block.mapped) + offset;
+        }
+        return allocation;
+    }
+
+    void LveMemoryAllocator::free(LveAllocation &allocation)
+    {
+        if (allocation.memory == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+
+        categoryBytes[static_cast<size_t>(allocation.category)] -= allocation.size;
+        if (allocation.block == LveTlsfAllocator::INVALID_NODE)
+        {
+            freeMemory(allocation.memoryTypeIndex, allocation.size, allocation.memory, allocation.mapped);
+            --dedicatedCount;
+            dedicatedBytes -= allocation.size;
+            allocation = LveAllocation{};
+            return;
+        }
+
+        Block &block{blocks[allocation.block]};
+        block.allocator.free(allocation.node);
+        --block.allocationCount;
+
+        if (block.allocationCount == 0)
+        {
+            bool lastOfKind{true};
+            for (const auto &other : blocks)
+            {
+                if (&other != &block && other.memory != VK_NULL_HANDLE &&
+                    other.memoryTypeIndex == block.memoryTypeIndex && other.linear == block.linear)
+                {
+                    lastOfKind = false;
+                    break;
+                }
+            }
+            if (!lastOfKind)
+            {
+                freeMemory(block.memoryTypeIndex, block.size, block.memory, block.mapped);
+                block = Block{};
+                unusedBlocks.push_back(allocation.block);
+            }
+        }
+        allocation = LveAllocation{};
+    }
+
+    VkMappedMemoryRange LveMemoryAllocator::mappedRange(
+        const LveAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) const
+    {
+        const VkDeviceSize memorySize{
+            allocation.block == LveTlsfAllocator::INVALID_NODE ? allocation.size : blocks[allocation.block].size};
+
+        VkDeviceSize begin{allocation.offset + offset};
+        VkDeviceSize end{size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size};
+        begin -= begin % nonCoherentAtomSize;
+        end = std::min(memorySize, (end + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize);
+
+        VkMappedMemoryRange range{};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = allocation.memory;
+        range.offset = begin;
+        // the end of the memory need not be atom aligned, only VK_WHOLE_SIZE is valid there
+        range.size = end == memorySize ? VK_WHOLE_SIZE : end - begin;
+        return range;
+    }
+
+    LveMemoryStats LveMemoryAllocator::getStats()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        LveMemoryStats stats{};
+        stats.dedicatedCount = dedicatedCount;
+        stats.allocationCount = dedicatedCount;
+        stats.reservedBytes = dedicatedBytes;
+        stats.usedBytes = dedicatedBytes;
+        stats.categoryBytes = categoryBytes;
+        for (const auto &block : blocks)
+        {
+            if (block.memory == VK_NULL_HANDLE)
+            {
+                continue;
+            }
+            ++stats.blockCount;
+            stats.allocationCount += block.allocationCount;
+            stats.reservedBytes += block.size;
+            stats.usedBytes += block.size - block.allocator.getFreeSize();
+        }
+        return stats;
+    }
+
+    std::vector<LveHeapBudget> LveMemoryAllocator::getHeapBudgets()
+    {
+        std::vector<LveHeapBudget> budgets(memoryProperties.memoryHeapCount);
+        for (uint32_t i{0}; i < memoryProperties.memoryHeapCount; ++i)
+        {
+            budgets[i].size = memoryProperties.memoryHeaps[i].size;
+            budgets[i].deviceLocal = memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+        }
+
+        if (getMemoryProperties2 != nullptr)
+        {
+            VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+            budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+            VkPhysicalDeviceMemoryProperties2 properties{};
+            properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+            properties.pNext = &budgetProperties;
+            getMemoryProperties2(physicalDevice, &properties);
+
+            for (uint32_t i{0}; i < memoryProperties.memoryHeapCount; ++i)
+            {
+                budgets[i].budget = budgetProperties.heapBudget[i];
+                budgets[i].usage = budgetProperties.heapUsage[i];
+            }
+            return budgets;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        for (uint32_t i{0}; i < memoryProperties.memoryHeapCount; ++i)
+        {
+            budgets[i].budget = static_cast<VkDeviceSize>(budgets[i].size * FALLBACK_BUDGET_FRACTION);
+            budgets[i].usage = heapBytes[i];
+        }
+        return budgets;
+    }
+
+    bool LveMemoryAllocator::allocateMemory(
+        uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory &memory, void *&mapped)
+    {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+        {
+            return false;
+        }
+
+        mapped = nullptr;
+        if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS)
+            {
+                vkFreeMemory(device, memory, nullptr);
+                return false;
+            }
+        }
+        heapBytes[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex] += size;
+        return true;
+    }
+
+    void LveMemoryAllocator::freeMemory(
+        uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory memory, void *mapped)
+    {
+        heapBytes[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex] -= size;
+        if (mapped != nullptr)
+        {
+            vkUnmapMemory(device, memory);
+        }
+        vkFreeMemory(device, memory, nullptr);
+    }
+
+    // small heaps, such as the host visible part of device memory, get proportionally smaller blocks
+    VkDeviceSize LveMemoryAllocator::preferredBlockSize(uint32_t memoryTypeIndex) const
+    {
+        const uint32_t heapIndex{memoryProperties.memoryTypes[memoryTypeIndex].heapIndex};
+        const VkDeviceSize heapSize{memoryProperties.memoryHeaps[heapIndex].size};
+        return heapSize > 0 && heapSize <= 1024ull * 1024 * 1024 ? std::min(BLOCK_SIZE, heapSize / 8) : BLOCK_SIZE;
+    }
+}
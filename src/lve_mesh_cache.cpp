@@ -0,0 +1,265 @@
+#include "lve_mesh_cache.hpp"
+#include "lve_mapped_file.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+namespace lve
+{
+    namespace
+    {
+        struct MeshCacheHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t flags;
+            uint32_t vertexStride;
+            uint32_t indexStride;
+            uint32_t meshletStride;
+            uint32_t lodStride;
+            uint64_t sourceSize;
+            int64_t sourceWriteTime;
+            uint64_t vertexOffset;
+            uint64_t vertexCount;
+            uint64_t indexOffset;
+            uint64_t indexCount;
+            uint64_t meshletOffset;
+            uint64_t meshletCount;
+            uint64_t lodOffset;
+            uint64_t lodCount;
+            float boundsMin[3];
+            float boundsMax[3];
+        };
+
+        constexpr uint64_t BLOB_ALIGNMENT{16};
+
+        uint64_t alignBlob(uint64_t offset)
+        {
+            return (offset + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+        }
+
+        bool sourceStamp(const std::string &sourcePath, uint64_t &size, int64_t &writeTime)
+        {
+            std::error_code error{};
+            size = std::filesystem::file_size(sourcePath, error);
+            if (error)
+            {
+                return false;
+            }
+            auto time{std::filesystem::last_write_time(sourcePath, error)};
+            if (error)
+            {
+                return false;
+            }
+            writeTime = static_cast<int64_t>(time.time_since_epoch().count());
+            return true;
+        }
+    }
+
+    std::string LveMeshCache::cachePath(const std::string &sourcePath)
+    {
+        return sourcePath + ".lvemesh";
+    }
+
+    bool LveMeshCache::load(const std::string &sourcePath, uint32_t flags, LveModel::Builder &builder)
+    {
+        uint64_t sourceSize{};
+        int64_t sourceWriteTime{};
+        if (!sourceStamp(sourcePath, sourceSize, sourceWriteTime))
+        {
+            return false;
+        }
+
+        const std::string path{cachePath(sourcePath)};
+        std::error_code error{};
+        if (!std::filesystem::is_regular_file(path, error))
+        {
+            return false;
+        }
+
+        // an unreadable sidecar is treated like a missing one, the caller parses the source instead
+        std::unique_ptr<LveMappedFile> mappedFile{};
+        try
+        {
+            mappedFile = std::make_unique<LveMappedFile>(path);
+        }
+        catch (const std::runtime_error &)
+        {
+            return false;
+        }
+        const LveMappedFile &file{*mappedFile};
+        if (file.size() < sizeof(MeshCacheHeader))
+        {
+            return false;
+        }
+
+        MeshCacheHeader header{};
+        std::memcpy(&header, file.data(), sizeof(header));
+
+        if (header.magic != MAGIC ||
+            header.version != VERSION ||
+            header.flags != flags ||
+            header.vertexStride != sizeof(LveModel::Vertex) ||
+            header.indexStride != sizeof(uint32_t) ||
+            header.meshletStride != sizeof(LveMeshlet) ||
+            header.lodStride != sizeof(LveModel::Lod) ||
+            header.sourceSize != sourceSize ||
+            header.sourceWriteTime != sourceWriteTime)
+        {
+            return false;
+        }
+
+        // counts are bounded by the file size before multiplying so the blob checks cannot overflow
+        const uint64_t fileSize{file.size()};
+        if (header.vertexCount > fileSize / sizeof(LveModel::Vertex) ||
+            header.indexCount > fileSize / sizeof(uint32_t) ||
+            header.meshletCount > fileSize / sizeof(LveMeshlet) ||
+            header.lodCount > fileSize / sizeof(LveModel::Lod) ||
+            header.vertexOffset % BLOB_ALIGNMENT != 0 ||
+            header.indexOffset % BLOB_ALIGNMENT != 0 ||
+            header.meshletOffset % BLOB_ALIGNMENT != 0 ||
+            header.lodOffset % BLOB_ALIGNMENT != 0 ||
+            header.vertexOffset < sizeof(MeshCacheHeader) ||
+            header.vertexOffset > fileSize ||
+            header.indexOffset > fileSize ||
+            header.meshletOffset > fileSize ||
+            header.lodOffset > fileSize ||
+            header.vertexCount * sizeof(LveModel::Vertex) > fileSize - header.vertexOffset ||
+            header.indexCount * sizeof(uint32_t) > fileSize - header.indexOffset ||
+            header.meshletCount * sizeof(LveMeshlet) > fileSize - header.meshletOffset ||
+            header.lodCount * sizeof(LveModel::Lod) > fileSize - header.lodOffset)
+        {
+            return false;
+        }
+
+        const auto *vertexData{
+            reinterpret_cast<const LveModel::Vertex *>(file.data() + header.vertexOffset)};
+        const auto *indexData{reinterpret_cast<const uint32_t *>(file.data() + header.indexOffset)};
+        const auto *meshletData{reinterpret_cast<const LveMeshlet *>(file.data() + header.meshletOffset)};
+        const auto *lodData{reinterpret_cast<const LveModel::Lod *>(file.data() + header.lodOffset)};
+
+        // a corrupt index would read out of bounds on the GPU, reject the whole file instead
+        for (uint64_t i{0}; i < header.indexCount; ++i)
+        {
+            if (indexData[i] >= header.vertexCount)
+            {
+                return false;
+            }
+        }
+        for (uint64_t i{0}; i < header.meshletCount; ++i)
+        {
+            const LveMeshlet &meshlet{meshletData[i]};
+            if (meshlet.indexCount % 3 != 0 ||
+                meshlet.firstIndex > header.indexCount ||
+                meshlet.indexCount > header.indexCount - meshlet.firstIndex)
+            {
+                return false;
+            }
+        }
+        for (uint64_t i{0}; i < header.lodCount; ++i)
+        {
+            const LveModel::Lod &lod{lodData[i]};
+            if (lod.indexCount % 3 != 0 ||
+                lod.firstIndex > header.indexCount ||
+                lod.indexCount > header.indexCount - lod.firstIndex ||
+                lod.firstMeshlet > header.meshletCount ||
+                lod.meshletCount > header.meshletCount - lod.firstMeshlet)
+            {
+                return false;
+            }
+        }
+
+        builder.vertices.assign(vertexData, vertexData + header.vertexCount);
+        builder.indices.assign(indexData, indexData + header.indexCount);
+        builder.meshlets.assign(meshletData, meshletData + header.meshletCount);
+        builder.lods.assign(lodData, lodData + header.lodCount);
+        builder.boundsMin = {header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]};
+        builder.boundsMax = {header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]};
+        return true;
+    }
+
+    bool LveMeshCache::store(const std::string &sourcePath, uint32_t flags, const LveModel::Builder &builder)
+    {
+        MeshCacheHeader header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.flags = flags;
+        header.vertexStride = sizeof(LveModel::Vertex);
+        header.indexStride = sizeof(uint32_t);
+        header.meshletStride = sizeof(LveMeshlet);
+        header.lodStride = sizeof(LveModel::Lod);
+        if (!sourceStamp(sourcePath, header.sourceSize, header.sourceWriteTime))
+        {
+            return false;
+        }
+        header.vertexCount = builder.vertices.size();
+        header.indexCount = builder.indices.size();
+        header.vertexOffset = alignBlob(sizeof(MeshCacheHeader));
+        header.indexOffset = alignBlob(header.vertexOffset + header.vertexCount * sizeof(LveModel::Vertex));
+        header.meshletCount = builder.meshlets.size();
+        header.meshletOffset = alignBlob(header.indexOffset + header.indexCount * sizeof(uint32_t));
+        header.lodCount = builder.lods.size();
+        header.lodOffset = alignBlob(header.meshletOffset + header.meshletCount * sizeof(LveMeshlet));
+        for (int i{0}; i < 3; ++i)
+        {
+            header.boundsMin[i] = builder.boundsMin[i];
+            header.boundsMax[i] = builder.boundsMax[i];
+        }
+
+        // write to a temporary file first so a crash never leaves a truncated sidecar behind
+        const std::string path{cachePath(sourcePath)};
+        const std::string tempPath{path + ".tmp"};
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                return false;
+            }
+
+            const char padding[BLOB_ALIGNMENT]{};
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(padding, header.vertexOffset - sizeof(header));
+            file.write(
+                reinterpret_cast<const char *>(builder.vertices.data()),
+                header.vertexCount * sizeof(LveModel::Vertex));
+            file.write(
+                padding,
+                header.indexOffset - header.vertexOffset - header.vertexCount * sizeof(LveModel::Vertex));
+            file.write(
+                reinterpret_cast<const char *>(builder.indices.data()),
+                header.indexCount * sizeof(uint32_t));
+            file.write(
+                padding,
+                header.meshletOffset - header.indexOffset - header.indexCount * sizeof(uint32_t));
+            file.write(
+                reinterpret_cast<const char *>(builder.meshlets.data()),
+                header.meshletCount * sizeof(LveMeshlet));
+            file.write(
+                padding,
+                header.lodOffset - header.meshletOffset - header.meshletCount * sizeof(LveMeshlet));
+            file.write(
+                reinterpret_cast<const char *>(builder.lods.data()),
+                header.lodCount * sizeof(LveModel::Lod));
+
+            if (!file.good())
+            {
+                file.close();
+                std::error_code error{};
+                std::filesystem::remove(tempPath, error);
+                return false;
+            }
+        }
+
+        std::error_code error{};
+        std::filesystem::rename(tempPath, path, error);
+        if (error)
+        {
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,365 @@
+#include "lve_mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+namespace lve
+{
+    namespace
+    {
+        constexpr uint32_t INVALID_INDEX{UINT32_MAX};
+
+        // FIFO cache model: a vertex is resident while fewer than cacheSize misses happened since
+        // it was loaded, which needs only one timestamp per vertex.
+        class FifoCache
+        {
+        public:
+            FifoCache(size_t vertexCount, uint32_t cacheSize)
+                : loadTime(vertexCount, 0), timestamp{cacheSize + 1}, cacheSize{cacheSize} {}
+
+            // Returns true on a miss.
+            bool access(uint32_t vertex)
+            {
+                if (timestamp - loadTime[vertex] > cacheSize)
+                {
+                    loadTime[vertex] = timestamp++;
+                    return true;
+                }
+                return false;
+            }
+
+            void flush() { timestamp += cacheSize + 1; }
+
+        private:
+            std::vector<uint32_t> loadTime;
+            uint32_t timestamp;
+            uint32_t cacheSize;
+        };
+
+        uint32_t accessTriangle(FifoCache &cache, const uint32_t *triangle)
+        {
+            return static_cast<uint32_t>(cache.access(triangle[0])) +
+                   static_cast<uint32_t>(cache.access(triangle[1])) +
+                   static_cast<uint32_t>(cache.access(triangle[2]));
+        }
+
+        // Vertex to triangle adjacency in CSR form.
+        struct TriangleAdjacency
+        {
+            TriangleAdjacency(const std::vector<uint32_t> &indices, size_t vertexCount)
+                : counts(vertexCount, 0), offsets(vertexCount + 1, 0), triangles(indices.size())
+            {
+                for (auto index : indices)
+                {
+                    ++counts[index];
+                }
+                for (size_t i{0}; i < vertexCount; ++i)
+                {
+                    offsets[i + 1] = offsets[i] + counts[i];
+                }
+
+                std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+                for (size_t i{0}; i < indices.size(); ++i)
+                {
+                    triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+
+            std::vector<uint32_t> counts;
+            std::vector<uint32_t> offsets;
+            std::vector<uint32_t> triangles;
+        };
+    }
+
+    LveVertexCacheStats LveMeshOptimizer::analyzeVertexCache(
+        const std::vector<uint32_t> &indices, size_t vertexCount, uint32_t cacheSize)
+    {
+        assert(indices.size() % 3 == 0 && "Index count must be a multiple of 3.");
+
+        LveVertexCacheStats stats{};
+        if (indices.empty())
+        {
+            return stats;
+        }
+
+        FifoCache cache{vertexCount, cacheSize};
+        std::vector<bool> referenced(vertexCount, false);
+        size_t misses{0};
+        size_t referencedCount{0};
+        for (auto index : indices)
+        {
+            misses += cache.access(index) ? 1 : 0;
+            if (!referenced[index])
+            {
+                referenced[index] = true;
+                ++referencedCount;
+            }
+        }
+
+        stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+        stats.atvr = static_cast<float>(misses) / static_cast<float>(referencedCount);
+        return stats;
+    }
+
+    // Tipsify, Sander et al. 2007: fan around the current vertex, then continue with the
+    // candidate that is still in the cache and has the fewest live triangles left. Dead ends
+    // fall back to recently used vertices, then to the first vertex with work left.
+    void LveMeshOptimizer::optimizeVertexCache(
+        std::vector<uint32_t> &indices, size_t vertexCount, uint32_t cacheSize)
+    {
+        assert(indices.size() % 3 == 0 && "Index count must be a multiple of 3.");
+
+        const size_t triangleCount{indices.size() / 3};
+        if (triangleCount == 0)
+        {
+            return;
+        }
+
+        TriangleAdjacency adjacency{indices, vertexCount};
+        std::vector<uint32_t> &liveTriangles{adjacency.counts};
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> deadEnds{};
+        std::vector<uint32_t> candidates{};
+        std::vector<uint32_t> result{};
+        deadEnds.reserve(indices.size());
+        result.reserve(indices.size());
+
+        uint32_t timestamp{cacheSize + 1};
+        uint32_t scanCursor{0};
+        uint32_t fanning{indices[0]};
+
+        while (fanning != INVALID_INDEX)
+        {
+            candidates.clear();
+
+            for (uint32_t i{adjacency.offsets[fanning]}; i < adjacency.offsets[fanning + 1]; ++i)
+            {
+                uint32_t triangle{adjacency.triangles[i]};
+                if (emitted[triangle])
+                {
+                    continue;
+                }
+                emitted[triangle] = true;
+
+                for (int corner{0}; corner < 3; ++corner)
+                {
+                    uint32_t vertex{indices[triangle * 3 + corner]};
+                    result.push_back(vertex);
+                    deadEnds.push_back(vertex);
+                    candidates.push_back(vertex);
+                    --liveTriangles[vertex];
+                    if (timestamp - cacheTime[vertex] > cacheSize)
+                    {
+                        cacheTime[vertex] = timestamp++;
+                    }
+                }
+            }
+
+            // prefer candidates that stay in the cache until all their triangles are emitted,
+            // and among those the one that entered the cache first
+            uint32_t next{INVALID_INDEX};
+            int64_t bestPriority{-1};
+            for (auto vertex : candidates)
+            {
+                if (liveTriangles[vertex] == 0)
+                {
+                    continue;
+                }
+                int64_t priority{0};
+                if (timestamp - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+                {
+                    priority = timestamp - cacheTime[vertex];
+                }
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    next = vertex;
+                }
+            }
+
+            if (next == INVALID_INDEX)
+            {
+                while (!deadEnds.empty() && next == INVALID_INDEX)
+                {
+                    uint32_t vertex{deadEnds.back()};
+                    deadEnds.pop_back();
+                    if (liveTriangles[vertex] > 0)
+                    {
+                        next = vertex;
+                    }
+                }
+                while (next == INVALID_INDEX && scanCursor < vertexCount)
+                {
+                    if (liveTriangles[scanCursor] > 0)
+                    {
+                        next = scanCursor;
+                    }
+                    else
+                    {
+                        ++scanCursor;
+                    }
+                }
+            }
+
+            fanning = next;
+        }
+
+        assert(result.size() == indices.size() && "Tipsify must emit every triangle.");
+        indices.swap(result);
+    }
+
+    // Linear-speed overdraw reduction, Sander et al. 2007: the cache friendly order is cut into
+    // clusters where the cache restarts anyway (hard boundaries) or where the running ACMR is
+    // within threshold of the cluster's (soft boundaries). Clusters are then sorted so those
+    // facing away from the mesh center, which are likely to occlude the rest, are drawn first.
+    void LveMeshOptimizer::optimizeOverdraw(
+        std::vector<uint32_t> &indices,
+        const std::vector<LveModel::Vertex> &vertices,
+        float threshold,
+        uint32_t cacheSize)
+    {
+        assert(indices.size() % 3 == 0 && "Index count must be a multiple of 3.");
+
+        const size_t triangleCount{indices.size() / 3};
+        if (triangleCount == 0)
+        {
+            return;
+        }
+
+        FifoCache cache{vertices.size(), cacheSize};
+
+        // the first cluster always starts at 0, a leading degenerate triangle never misses 3 times
+        std::vector<size_t> hardBoundaries{0};
+        for (size_t triangle{0}; triangle < triangleCount; ++triangle)
+        {
+            if (accessTriangle(cache, &indices[triangle * 3]) == 3 && triangle > 0)
+            {
+                hardBoundaries.push_back(triangle);
+            }
+        }
+        hardBoundaries.push_back(triangleCount);
+
+        std::vector<size_t> clusters{};
+        for (size_t i{0}; i + 1 < hardBoundaries.size(); ++i)
+        {
+            const size_t start{hardBoundaries[i]};
+            const size_t end{hardBoundaries[i + 1]};
+
+            cache.flush();
+            uint32_t clusterMisses{0};
+            for (size_t triangle{start}; triangle < end; ++triangle)
+            {
+                clusterMisses += accessTriangle(cache, &indices[triangle * 3]);
+            }
+            const float clusterThreshold{
+                threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start)};
+
+            cache.flush();
+            clusters.push_back(start);
+            size_t softStart{start};
+            uint32_t softMisses{0};
+            for (size_t triangle{start}; triangle + 1 < end; ++triangle)
+            {
+                softMisses += accessTriangle(cache, &indices[triangle * 3]);
+                float softAcmr{static_cast<float>(softMisses) / static_cast<float>(triangle + 1 - softStart)};
+                if (softAcmr <= clusterThreshold)
+                {
+                    softStart = triangle + 1;
+                    softMisses = 0;
+                    clusters.push_back(softStart);
+                    cache.flush();
+                }
+            }
+        }
+
+        glm::vec3 meshCenter{0.f};
+        for (const auto &vertex : vertices)
+        {
+            meshCenter += vertex.position;
+        }
+        meshCenter /= static_cast<float>(std::max<size_t>(vertices.size(), 1));
+
+        std::vector<float> sortKeys(clusters.size());
+        for (size_t i{0}; i < clusters.size(); ++i)
+        {
+            const size_t end{i + 1 < clusters.size() ? clusters[i + 1] : triangleCount};
+
+            glm::vec3 weightedCenter{0.f};
+            glm::vec3 weightedNormal{0.f};
+            float totalArea{0.f};
+            for (size_t triangle{clusters[i]}; triangle < end; ++triangle)
+            {
+                const glm::vec3 &p0{vertices[indices[triangle * 3 + 0]].position};
+                const glm::vec3 &p1{vertices[indices[triangle * 3 + 1]].position};
+                const glm::vec3 &p2{vertices[indices[triangle * 3 + 2]].position};
+
+                glm::vec3 normal{glm::cross(p1 - p0, p2 - p0)};
+                float area{glm::length(normal)};
+                weightedCenter += (p0 + p1 + p2) * (area / 3.f);
+                weightedNormal += normal;
+                totalArea += area;
+            }
+
+            float normalLength{glm::length(weightedNormal)};
+            if (totalArea <= 0.f || normalLength <= 0.f)
+            {
+                sortKeys[i] = 0.f;
+                continue;
+            }
+            sortKeys[i] = glm::dot(weightedCenter / totalArea - meshCenter, weightedNormal / normalLength);
+        }
+
+        std::vector<size_t> order(clusters.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                         { return sortKeys[a] > sortKeys[b]; });
+
+        std::vector<uint32_t> result{};
+        result.reserve(indices.size());
+        for (auto cluster : order)
+        {
+            const size_t end{cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount};
+            result.insert(result.end(), indices.begin() + clusters[cluster] * 3, indices.begin() + end * 3);
+        }
+
+        assert(result.size() == indices.size() && "Clusters must cover every triangle.");
+        indices.swap(result);
+    }
+
+    void LveMeshOptimizer::optimizeVertexFetch(
+        std::vector<LveModel::Vertex> &vertices, std::vector<uint32_t> &indices)
+    {
+        std::vector<uint32_t> remap(vertices.size(), INVALID_INDEX);
+        std::vector<LveModel::Vertex> result{};
+        result.reserve(vertices.size());
+
+        for (auto &index : indices)
+        {
+            if (remap[index] == INVALID_INDEX)
+            {
+                remap[index] = static_cast<uint32_t>(result.size());
+                result.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+
+        // unreferenced vertices are kept at the end so the vertex count does not change
+        for (size_t i{0}; i < vertices.size(); ++i)
+        {
+            if (remap[i] == INVALID_INDEX)
+            {
+                result.push_back(vertices[i]);
+            }
+        }
+        vertices.swap(result);
+    }
+
+    void LveMeshOptimizer::optimize(LveModel::Builder &builder)
+    {
+        optimizeVertexCache(builder.indices, builder.vertices.size());
+        optimizeOverdraw(builder.indices, builder.vertices);
+        optimizeVertexFetch(builder.vertices, builder.indices);
+    }
+}
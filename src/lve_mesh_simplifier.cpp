@@ -0,0 +1,548 @@
+#include "lve_mesh_simplifier.hpp"
+#include "lve_mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include <utility>
+
+namespace lve
+{
+    namespace
+    {
+        constexpr uint32_t INVALID_INDEX{UINT32_MAX};
+
+        // Symmetric 4x4 quadric of area weighted planes, kept in double to survive summation.
+        struct Quadric
+        {
+            double a00{0}, a01{0}, a02{0}, a11{0}, a12{0}, a22{0};
+            double b0{0}, b1{0}, b2{0};
+            double c{0};
+            double weight{0};
+
+            void addPlane(const glm::vec3 &normal, float distance, float planeWeight)
+            {
+                const double x{normal.x}, y{normal.y}, z{normal.z}, d{distance}, w{planeWeight};
+                a00 += w * x * x;
+                a01 += w * x * y;
+                a02 += w * x * z;
+                a11 += w * y * y;
+                a12 += w * y * z;
+                a22 += w * z * z;
+                b0 += w * x * d;
+                b1 += w * y * d;
+                b2 += w * z * d;
+                c += w * d * d;
+                weight += w;
+            }
+
+            void add(const Quadric &other)
+            {
+                a00 += other.a00;
+                a01 += other.a01;
+                a02 += other.a02;
+                a11 += other.a11;
+                a12 += other.a12;
+                a22 += other.a22;
+                b0 += other.b0;
+                b1 += other.b1;
+                b2 += other.b2;
+                c += other.c;
+                weight += other.weight;
+            }
+
+            // Weighted mean squared distance of p to the accumulated planes.
+            double evaluate(const glm::vec3 &p) const
+            {
+                const double x{p.x}, y{p.y}, z{p.z};
+                double error{
+                    a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z +
+                    a11 * y * y + 2 * a12 * y * z + a22 * z * z +
+                    2 * (b0 * x + b1 * y + b2 * z) + c};
+                return weight > 0 ? std::max(error, 0.0) / weight : 0.0;
+            }
+        };
+
+        struct Collapse
+        {
+            double cost;
+            uint32_t from;
+            uint32_t to;
+            uint32_t fromVersion;
+            uint32_t toVersion;
+
+            bool operator>(const Collapse &other) const { return cost > other.cost; }
+        };
+
+        struct WedgeRemap
+        {
+            uint32_t from;
+            uint32_t to;
+        };
+
+        float attributeDistance(const LveModel::Vertex &a, const LveModel::Vertex &b)
+        {
+            glm::vec3 normal{a.normal - b.normal};
+            glm::vec3 color{a.color - b.color};
+            glm::vec2 uv{a.uv - b.uv};
+            return glm::dot(normal, normal) + glm::dot(color, color) + glm::dot(uv, uv);
+        }
+
+        class Simplifier
+        {
+        public:
+            Simplifier(const std::vector<LveModel::Vertex> &vertices, const std::vector<uint32_t> &indices)
+                : vertices{vertices}, triangles{indices}
+            {
+                weldPositions();
+                buildAdjacency();
+                lockBorders();
+                computeQuadrics();
+            }
+
+            std::vector<uint32_t> run(size_t targetIndexCount, float &error)
+            {
+                for (uint32_t position{0}; position < positionCount(); ++position)
+                {
+                    pushNeighbourCollapses(position);
+                }
+
+                double maxCost{0};
+                std::vector<WedgeRemap> remap{};
+                while (liveTriangleCount * 3 > targetIndexCount && !heap.empty())
+                {
+                    Collapse collapse{heap.top()};
+                    heap.pop();
+
+                    if (collapsedInto[collapse.from] != INVALID_INDEX ||
+                        collapsedInto[collapse.to] != INVALID_INDEX ||
+                        collapse.fromVersion != versions[collapse.from] ||
+                        collapse.toVersion != versions[collapse.to])
+                    {
+                        continue;
+                    }
+
+                    // neighbouring collapses can change the triangles around an edge without
+                    // touching its end points, so the cost is re-evaluated before committing
+                    double cost{0};
+                    if (!evaluate(collapse.from, collapse.to, cost, remap))
+                    {
+                        continue;
+                    }
+                    if (cost > collapse.cost * 1.0001 + 1e-12)
+                    {
+                        collapse.cost = cost;
+                        heap.push(collapse);
+                        continue;
+                    }
+
+                    apply(collapse.from, collapse.to, remap);
+                    maxCost = std::max(maxCost, cost);
+                }
+
+                error = static_cast<float>(std::sqrt(maxCost)) * extent;
+
+                std::vector<uint32_t> result{};
+                result.reserve(liveTriangleCount * 3);
+                for (size_t triangle{0}; triangle < removed.size(); ++triangle)
+                {
+                    if (!removed[triangle])
+                    {
+                        result.insert(
+                            result.end(), triangles.begin() + triangle * 3, triangles.begin() + triangle * 3 + 3);
+                    }
+                }
+                return result;
+            }
+
+        private:
+            uint32_t positionCount() const { return static_cast<uint32_t>(positions.size()); }
+            uint32_t positionOf(uint32_t vertex) const { return vertexPosition[vertex]; }
+
+            // Groups vertices with bitwise equal positions, positions are then rescaled to the
+            // unit cube so costs do not depend on the model size.
+            void weldPositions()
+            {
+                std::vector<uint32_t> order(vertices.size());
+                std::iota(order.begin(), order.end(), 0);
+                auto less = [&](uint32_t a, uint32_t b)
+                {
+                    const glm::vec3 &pa{vertices[a].position};
+                    const glm::vec3 &pb{vertices[b].position};
+                    if (pa.x != pb.x)
+                        return pa.x < pb.x;
+                    if (pa.y != pb.y)
+                        return pa.y < pb.y;
+                    return pa.z < pb.z;
+                };
+                std::sort(order.begin(), order.end(), less);
+
+                vertexPosition.assign(vertices.size(), INVALID_INDEX);
+                glm::vec3 minimum{vertices.empty() ? glm::vec3{0.f} : vertices[order[0]].position};
+                glm::vec3 maximum{minimum};
+                for (size_t i{0}; i < order.size(); ++i)
+                {
+                    if (i == 0 || less(order[i - 1], order[i]))
+                    {
+                        positions.push_back(vertices[order[i]].position);
+                        minimum = glm::min(minimum, positions.back());
+                        maximum = glm::max(maximum, positions.back());
+                    }
+                    vertexPosition[order[i]] = positionCount() - 1;
+                }
+
+                glm::vec3 size{maximum - minimum};
+                extent = std::max(std::max(size.x, size.y), std::max(size.z, 1e-20f));
+                for (auto &position : positions)
+                {
+                    position = (position - minimum) / extent;
+                }
+                collapsedInto.assign(positions.size(), INVALID_INDEX);
+                versions.assign(positions.size(), 0);
+                locked.assign(positions.size(), false);
+            }
+
+            void buildAdjacency()
+            {
+                const size_t triangleCount{triangles.size() / 3};
+                removed.assign(triangleCount, false);
+                positionTriangles.assign(positions.size(), {});
+                liveTriangleCount = 0;
+
+                for (uint32_t triangle{0}; triangle < triangleCount; ++triangle)
+                {
+                    uint32_t a{positionOf(triangles[triangle * 3])};
+                    uint32_t b{positionOf(triangles[triangle * 3 + 1])};
+                    uint32_t c{positionOf(triangles[triangle * 3 + 2])};
+                    if (a == b || b == c || c == a)
+                    {
+                        removed[triangle] = true;
+                        continue;
+                    }
+                    positionTriangles[a].push_back(triangle);
+                    positionTriangles[b].push_back(triangle);
+                    positionTriangles[c].push_back(triangle);
+                    ++liveTriangleCount;
+                }
+            }
+
+            // A directed edge p->q without a matching q->p lies on an open border.
+            void lockBorders()
+            {
+                for (uint32_t position{0}; position < positionCount(); ++position)
+                {
+                    for (auto triangle : positionTriangles[position])
+                    {
+                        uint32_t next{INVALID_INDEX};
+                        for (int corner{0}; corner < 3; ++corner)
+                        {
+                            if (positionOf(triangles[triangle * 3 + corner]) == position)
+                            {
+                                next = positionOf(triangles[triangle * 3 + (corner + 1) % 3]);
+                            }
+                        }
+                        if (!hasDirectedEdge(next, position))
+                        {
+                            locked[position] = true;
+                            locked[next] = true;
+                        }
+                    }
+                }
+            }
+
+            bool hasDirectedEdge(uint32_t from, uint32_t to) const
+            {
+                for (auto triangle : positionTriangles[from])
+                {
+                    for (int corner{0}; corner < 3; ++corner)
+                    {
+                        if (positionOf(triangles[triangle * 3 + corner]) == from &&
+                            positionOf(triangles[triangle * 3 + (corner + 1) % 3]) == to)
+                        {
+                            return true;
+                        }
+                    }
+                }
+                return false;
+            }
+
+            void computeQuadrics()
+            {
+                quadrics.assign(positions.size(), Quadric{});
+                for (size_t triangle{0}; triangle < removed.size(); ++triangle)
+                {
+                    if (removed[triangle])
+                    {
+                        continue;
+                    }
+                    uint32_t a{positionOf(triangles[triangle * 3])};
+                    uint32_t b{positionOf(triangles[triangle * 3 + 1])};
+                    uint32_t c{positionOf(triangles[triangle * 3 + 2])};
+
+                    glm::vec3 normal{glm::cross(positions[b] - positions[a], positions[c] - positions[a])};
+                    float length{glm::length(normal)};
+                    if (length <= 0.f)
+                    {
+                        continue;
+                    }
+                    normal /= length;
+                    float distance{-glm::dot(normal, positions[a])};
+                    for (auto position : {a, b, c})
+                    {
+                        quadrics[position].addPlane(normal, distance, length * 0.5f);
+                    }
+                }
+            }
+
+            void pushNeighbourCollapses(uint32_t position)
+            {
+                std::vector<uint32_t> neighbours{};
+                for (auto triangle : positionTriangles[position])
+                {
+                    for (int corner{0}; corner < 3; ++corner)
+                    {
+                        uint32_t neighbour{positionOf(triangles[triangle * 3 + corner])};
+                        if (neighbour != position &&
+                            std::find(neighbours.begin(), neighbours.end(), neighbour) == neighbours.end())
+                        {
+                            neighbours.push_back(neighbour);
+                        }
+                    }
+                }
+
+                std::vector<WedgeRemap> remap{};
+                for (auto neighbour : neighbours)
+                {
+                    for (auto [from, to] : {std::pair{position, neighbour}, std::pair{neighbour, position}})
+                    {
+                        double cost{0};
+                        if (evaluate(from, to, cost, remap))
+                        {
+                            heap.push(Collapse{cost, from, to, versions[from], versions[to]});
+                        }
+                    }
+                }
+            }
+
+            // Checks the collapse of position from onto position to and computes its cost and
+            // how the attribute vertices of from map onto those of to.
+            bool evaluate(uint32_t from, uint32_t to, double &cost, std::vector<WedgeRemap> &remap) const
+            {
+                if (locked[from])
+                {
+                    return false;
+                }
+
+                remap.clear();
+                bool adjacent{false};
+                for (auto triangle : positionTriangles[from])
+                {
+                    const uint32_t *corners{&triangles[triangle * 3]};
+                    uint32_t fromCorner{0};
+                    bool containsTarget{false};
+                    for (uint32_t corner{0}; corner < 3; ++corner)
+                    {
+                        if (positionOf(corners[corner]) == from)
+                        {
+                            fromCorner = corner;
+                        }
+                        containsTarget |= positionOf(corners[corner]) == to;
+                    }
+                    adjacent |= containsTarget;
+
+                    // triangles around the edge disappear, the others must not flip
+                    if (!containsTarget)
+                    {
+                        const glm::vec3 &p1{positions[positionOf(corners[(fromCorner + 1) % 3])]};
+                        const glm::vec3 &p2{positions[positionOf(corners[(fromCorner + 2) % 3])]};
+                        glm::vec3 before{glm::cross(p1 - positions[from], p2 - positions[from])};
+                        glm::vec3 after{glm::cross(p1 - positions[to], p2 - positions[to])};
+                        if (glm::dot(before, after) <= 0.f)
+                        {
+                            return false;
+                        }
+                    }
+
+                    uint32_t wedge{corners[fromCorner]};
+                    if (std::none_of(remap.begin(), remap.end(), [&](const WedgeRemap &r)
+                                     { return r.from == wedge; }))
+                    {
+                        remap.push_back(WedgeRemap{wedge, INVALID_INDEX});
+                    }
+                }
+                if (!adjacent)
+                {
+                    return false;
+                }
+
+                // prefer the target vertex sharing a triangle with the moving one, which keeps
+                // attribute seams intact, otherwise the closest attributes around the target
+                double attributeCost{0};
+                for (auto &entry : remap)
+                {
+                    for (auto triangle : positionTriangles[from])
+                    {
+                        const uint32_t *corners{&triangles[triangle * 3]};
+                        if (corners[0] != entry.from && corners[1] != entry.from && corners[2] != entry.from)
+                        {
+                            continue;
+                        }
+                        for (int corner{0}; corner < 3; ++corner)
+                        {
+                            if (positionOf(corners[corner]) == to)
+                            {
+                                entry.to = corners[corner];
+                            }
+                        }
+                        if (entry.to != INVALID_INDEX)
+                        {
+                            break;
+                        }
+                    }
+
+                    if (entry.to == INVALID_INDEX)
+                    {
+                        float best{INFINITY};
+                        for (auto triangle : positionTriangles[to])
+                        {
+                            for (int corner{0}; corner < 3; ++corner)
+                            {
+                                uint32_t candidate{triangles[triangle * 3 + corner]};
+                                if (positionOf(candidate) != to)
+                                {
+                                    continue;
+                                }
+                                float distance{attributeDistance(vertices[entry.from], vertices[candidate])};
+                                if (distance < best)
+                                {
+                                    best = distance;
+                                    entry.to = candidate;
+                                }
+                            }
+                        }
+                    }
+                    attributeCost += attributeDistance(vertices[entry.from], vertices[entry.to]);
+                }
+
+                Quadric combined{quadrics[from]};
+                combined.add(quadrics[to]);
+                cost = combined.evaluate(positions[to]) +
+                       attributeCost * ATTRIBUTE_WEIGHT_SQUARED / static_cast<double>(remap.size());
+                return true;
+            }
+
+            void apply(uint32_t from, uint32_t to, const std::vector<WedgeRemap> &remap)
+            {
+                for (auto triangle : positionTriangles[from])
+                {
+                    uint32_t *corners{&triangles[triangle * 3]};
+                    bool containsTarget{
+                        positionOf(corners[0]) == to || positionOf(corners[1]) == to || positionOf(corners[2]) == to};
+                    if (containsTarget)
+                    {
+                        removed[triangle] = true;
+                        --liveTriangleCount;
+                        for (int corner{0}; corner < 3; ++corner)
+                        {
+                            uint32_t position{positionOf(corners[corner])};
+                            if (position != from)
+                            {
+                                auto &around{positionTriangles[position]};
+                                around.erase(std::find(around.begin(), around.end(), triangle));
+                            }
+                        }
+                        continue;
+                    }
+
+                    for (int corner{0}; corner < 3; ++corner)
+                    {
+                        for (const auto &entry : remap)
+                        {
+                            if (corners[corner] == entry.from)
+                            {
+                                corners[corner] = entry.to;
+                                break;
+                            }
+                        }
+                    }
+                    positionTriangles[to].push_back(triangle);
+                }
+
+                positionTriangles[from].clear();
+                collapsedInto[from] = to;
+                quadrics[to].add(quadrics[from]);
+                ++versions[from];
+                ++versions[to];
+                pushNeighbourCollapses(to);
+            }
+
+            static constexpr double ATTRIBUTE_WEIGHT_SQUARED{
+                static_cast<double>(LveMeshSimplifier::ATTRIBUTE_WEIGHT) * LveMeshSimplifier::ATTRIBUTE_WEIGHT};
+
+            const std::vector<LveModel::Vertex> &vertices;
+            std::vector<uint32_t> triangles;
+            std::vector<bool> removed{};
+            size_t liveTriangleCount{0};
+
+            std::vector<uint32_t> vertexPosition{};
+            std::vector<glm::vec3> positions{};
+            float extent{1.f};
+            std::vector<std::vector<uint32_t>> positionTriangles{};
+            std::vector<Quadric> quadrics{};
+            std::vector<uint32_t> collapsedInto{};
+            std::vector<uint32_t> versions{};
+            std::vector<bool> locked{};
+
+            std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap{};
+        };
+    }
+
+    std::vector<uint32_t> LveMeshSimplifier::simplify(
+        const std::vector<LveModel::Vertex> &vertices,
+        const std::vector<uint32_t> &indices,
+        size_t targetIndexCount,
+        float &error)
+    {
+        assert(indices.size() % 3 == 0 && "Index count must be a multiple of 3.");
+
+        error = 0.f;
+        if (indices.size() <= targetIndexCount)
+        {
+            return indices;
+        }
+        return Simplifier{vertices, indices}.run(targetIndexCount, error);
+    }
+
+    void LveMeshSimplifier::generateLods(LveModel::Builder &builder)
+    {
+        const std::vector<uint32_t> fullIndices{builder.indices};
+
+        builder.lods.clear();
+        builder.lods.push_back(LveModel::Lod{0, static_cast<uint32_t>(fullIndices.size()), 0, 0, 0.f});
+
+        for (auto target : LOD_TARGETS)
+        {
+            size_t targetIndexCount{static_cast<size_t>(fullIndices.size() / 3 * target) * 3};
+            float error{0.f};
+            auto lodIndices{simplify(builder.vertices, fullIndices, targetIndexCount, error)};
+
+            // stop once collapses run out, another level would only duplicate the previous one
+            const LveModel::Lod &previous{builder.lods.back()};
+            if (lodIndices.empty() || lodIndices.size() >= previous.indexCount * 9 / 10)
+            {
+                break;
+            }
+
+            LveMeshOptimizer::optimizeVertexCache(lodIndices, builder.vertices.size());
+            builder.lods.push_back(LveModel::Lod{
+                static_cast<uint32_t>(builder.indices.size()),
+                static_cast<uint32_t>(lodIndices.size()),
+                0,
+                0,
+                std::max(error, previous.error)});
+            builder.indices.insert(builder.indices.end(), lodIndices.begin(), lodIndices.end());
+        }
+    }
+}
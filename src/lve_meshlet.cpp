@@ -0,0 +1,53 @@
+#include "lve_meshlet.hpp"
+
+namespace lve
+{
+    LveMeshletCuller::LveMeshletCuller(
+        const glm::mat4 &projectionView,
+        const glm::mat4 &modelMatrix,
+        const glm::vec3 &worldCameraPosition,
+        bool coneCulling)
+        : coneCulling{coneCulling}
+    {
+        // Gribb/Hartmann plane extraction on the full model to clip transform yields the planes in
+        // model space; depth is [0, 1] so the near plane is the third row alone
+        const glm::mat4 clip{projectionView * modelMatrix};
+        auto row = [&](int i)
+        { return glm::vec4{clip[0][i], clip[1][i], clip[2][i], clip[3][i]}; };
+
+        frustumPlanes[0] = row(3) + row(0);
+        frustumPlanes[1] = row(3) - row(0);
+        frustumPlanes[2] = row(3) + row(1);
+        frustumPlanes[3] = row(3) - row(1);
+        frustumPlanes[4] = row(2);
+        frustumPlanes[5] = row(3) - row(2);
+        for (auto &plane : frustumPlanes)
+        {
+            plane = plane / glm::length(glm::vec3{plane});
+        }
+
+        cameraPosition = glm::vec3{glm::inverse(modelMatrix) * glm::vec4{worldCameraPosition, 1.f}};
+    }
+
+    bool LveMeshletCuller::isVisible(const LveMeshlet &meshlet) const
+    {
+        for (const auto &plane : frustumPlanes)
+        {
+            if (glm::dot(glm::vec3{plane}, meshlet.center) + plane.w < -meshlet.radius)
+            {
+                return false;
+            }
+        }
+
+        if (coneCulling && meshlet.coneCutoff < 1.f)
+        {
+            glm::vec3 toApex{meshlet.coneApex - cameraPosition};
+            float distance{glm::length(toApex)};
+            if (distance > 0.f && glm::dot(toApex / distance, meshlet.coneAxis) >= meshlet.coneCutoff)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
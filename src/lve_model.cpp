@@ -1,119 +1,404 @@
 #include "lve_model.hpp"
-#include "lve_utils.hpp"
+#include "lve_mesh_optimizer.hpp"
+#include "lve_residency_manager.hpp"
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <iostream>
-#include <unordered_map>
 
-namespace std
+namespace lve
 {
-    template <>
-    struct hash<lve::LveModel::Vertex>
+    namespace
     {
-        size_t operator()(lve::LveModel::Vertex const &vertex) const
+        uint16_t quantizeUnorm16(float value)
         {
-            size_t seed{0};
-            lve::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-            return seed;
+            return static_cast<uint16_t>(std::round(glm::clamp(value, 0.f, 1.f) * 65535.f));
         }
-    };
-}
 
-namespace lve
-{
-    LveModel::LveModel(LveDevice &lveDevice, const Builder &builder)
-        : lveDevice(lveDevice)
+        int16_t quantizeSnorm16(float value)
+        {
+            return static_cast<int16_t>(std::round(glm::clamp(value, -1.f, 1.f) * 32767.f));
+        }
+
+        uint8_t quantizeUnorm8(float value)
+        {
+            return static_cast<uint8_t>(std::round(glm::clamp(value, 0.f, 1.f) * 255.f));
+        }
+
+        // Octahedral mapping of a unit vector onto [-1, 1]^2, see Cigolle et al. 2014.
+        glm::vec2 encodeOctahedral(const glm::vec3 &normal)
+        {
+            float l1Norm{std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z)};
+            if (l1Norm <= 0.f)
+            {
+                return glm::vec2{0.f};
+            }
+
+            glm::vec2 encoded{normal.x / l1Norm, normal.y / l1Norm};
+            if (normal.z < 0.f)
+            {
+                encoded = glm::vec2{
+                    (1.f - std::abs(encoded.y)) * (encoded.x >= 0.f ? 1.f : -1.f),
+                    (1.f - std::abs(encoded.x)) * (encoded.y >= 0.f ? 1.f : -1.f)};
+            }
+            return encoded;
+        }
+
+        // Must match octahedralDecode in shaders/compact_shader.vert.
+        glm::vec3 decodeOctahedral(const glm::vec2 &encoded)
+        {
+            glm::vec3 normal{encoded.x, encoded.y, 1.f - std::abs(encoded.x) - std::abs(encoded.y)};
+            float fold{std::max(-normal.z, 0.f)};
+            normal.x += normal.x >= 0.f ? -fold : fold;
+            normal.y += normal.y >= 0.f ? -fold : fold;
+            return glm::normalize(normal);
+        }
+    }
+
+    LveModel::LveModel(LveGeometryArena &geometryArena, const Builder &builder, VertexFormat vertexFormat)
+        : geometryArena{geometryArena}, vertexFormat{vertexFormat}
     {
-        createVertexBuffers(builder.vertices);
-        createIndexBuffers(builder.indices);
+        // narrowing may duplicate vertices, so it has to be decided before the vertex upload
+        std::vector<Vertex> splitVertices{};
+        std::vector<uint16_t> shortIndices{};
+        bool split{narrowIndices(builder, splitVertices, shortIndices)};
+        const std::vector<Vertex> &vertices{split ? splitVertices : builder.vertices};
+
+        if (vertexFormat == VertexFormat::Compact)
+        {
+            auto compactVertices{compressVertices(vertices, builder.boundsMin, builder.boundsMax)};
+            createVertexBuffers(
+                compactVertices.data(),
+                sizeof(CompactVertex),
+                static_cast<uint32_t>(compactVertices.size()));
+        }
+        else
+        {
+            createVertexBuffers(vertices.data(), sizeof(Vertex), static_cast<uint32_t>(vertices.size()));
+        }
+
+        if (indexType == VK_INDEX_TYPE_UINT16)
+        {
+            createIndexBuffers(
+                shortIndices.data(), sizeof(uint16_t), static_cast<uint32_t>(shortIndices.size()));
+        }
+        else
+        {
+            createIndexBuffers(
+                builder.indices.data(), sizeof(uint32_t), static_cast<uint32_t>(builder.indices.size()));
+        }
+
+        meshlets = builder.meshlets;
+        lods = builder.lods;
+        if (lods.empty())
+        {
+            lods.push_back(Lod{
+                0, static_cast<uint32_t>(builder.indices.size()), 0, static_cast<uint32_t>(meshlets.size()), 0.f});
+        }
+
+        boundsCenter = (builder.boundsMin + builder.boundsMax) * 0.5f;
+        boundsRadius = glm::length(builder.boundsMax - builder.boundsMin) * 0.5f;
     }
 
     LveModel::~LveModel()
     {
+        if (residencyManager != nullptr)
+        {
+            residencyManager->untrack(*this);
+        }
+        // frames in flight may still draw from the ranges
+        geometryArena.getDevice().deletionQueue().push(
+            [&arena = geometryArena, vertices = vertexAllocation, indices = indexAllocation]() mutable
+            {
+                arena.free(vertices);
+                arena.free(indices);
+            });
     }
 
     std::unique_ptr<LveModel> LveModel::createModelFromFile(
-        LveDevice &device, const std::string &filePath)
+        LveGeometryArena &geometryArena, const std::string &filePath, bool optimize, VertexFormat vertexFormat)
     {
+        auto startTime{std::chrono::high_resolution_clock::now()};
+
         Builder builder{};
-        builder.loadModel(filePath);
+        LveVertexCacheStats before{};
+        LveVertexCacheStats after{};
+        bool warmStart{builder.loadCached(filePath, optimize, &before, &after)};
+
+        float loadTime{std::chrono::duration<float, std::chrono::milliseconds::period>(
+                           std::chrono::high_resolution_clock::now() - startTime)
+                           .count()};
         std::cout << "Vertex count: " << builder.vertices.size() << "\n";
-        return std::make_unique<LveModel>(device, builder);
+        std::cout << "Load time (" << (warmStart ? "warm" : "cold") << "): " << loadTime << " ms\n";
+
+        if (warmStart)
+        {
+            std::cout << "ACMR: " << after.acmr << ", ATVR: " << after.atvr << "\n";
+        }
+        else
+        {
+            std::cout << "ACMR: " << before.acmr << " -> " << after.acmr
+                      << ", ATVR: " << before.atvr << " -> " << after.atvr << "\n";
+        }
+        std::cout << "Meshlet count: " << builder.meshlets.size() << "\n";
+        for (size_t i{0}; i < builder.lods.size(); ++i)
+        {
+            std::cout << "LOD " << i << ": " << builder.lods[i].indexCount / 3
+                      << " triangles, error " << builder.lods[i].error << "\n";
+        }
+
+        return std::make_unique<LveModel>(geometryArena, builder, vertexFormat);
     }
 
-    void LveModel::createVertexBuffers(const std::vector<Vertex> &vertices)
+    bool LveModel::narrowIndices(
+        const Builder &builder,
+        std::vector<Vertex> &splitVertices,
+        std::vector<uint16_t> &shortIndices)
     {
-        vertexCount = static_cast<uint32_t>(vertices.size());
-        assert(vertexCount >= 3 && "Vertex count must be at least 3.");
-        VkDeviceSize bufferSize{sizeof(vertices[0]) * vertexCount};
-        uint32_t vertexSize{sizeof(vertices[0])};
+        constexpr size_t MAX_SHORT_VERTICES{size_t{UINT16_MAX} + 1};
+        const auto &vertices{builder.vertices};
+        const auto &indices{builder.indices};
+
+        indexType = VK_INDEX_TYPE_UINT32;
+        submeshes.assign(1, Submesh{0, static_cast<uint32_t>(indices.size()), 0});
+        if (indices.empty())
+        {
+            return false;
+        }
+
+        if (vertices.size() <= MAX_SHORT_VERTICES)
+        {
+            indexType = VK_INDEX_TYPE_UINT16;
+            shortIndices.assign(indices.begin(), indices.end());
+            return false;
+        }
+
+        // greedily cut the triangle list into runs referencing at most 65536 vertices, each run
+        // gets its own copy of the vertices it uses so they form a contiguous range
+        std::vector<uint32_t> localIndex(vertices.size(), UINT32_MAX);
+        std::vector<uint32_t> runVertices{};
+        std::vector<Submesh> splitSubmeshes{};
+        Submesh current{};
+
+        for (size_t i{0}; i + 2 < indices.size(); i += 3)
+        {
+            const uint32_t a{indices[i]}, b{indices[i + 1]}, c{indices[i + 2]};
+            size_t newVertices{
+                static_cast<size_t>(localIndex[a] == UINT32_MAX) +
+                static_cast<size_t>(localIndex[b] == UINT32_MAX && b != a) +
+                static_cast<size_t>(localIndex[c] == UINT32_MAX && c != a && c != b)};
+
+            if (runVertices.size() + newVertices > MAX_SHORT_VERTICES)
+            {
+                splitSubmeshes.push_back(current);
+                for (auto vertex : runVertices)
+                {
+                    localIndex[vertex] = UINT32_MAX;
+                }
+                runVertices.clear();
+                current = Submesh{static_cast<uint32_t>(i), 0, static_cast<int32_t>(splitVertices.size())};
+            }
+
+            for (auto vertex : {a, b, c})
+            {
+                if (localIndex[vertex] == UINT32_MAX)
+                {
+                    localIndex[vertex] = static_cast<uint32_t>(runVertices.size());
+                    runVertices.push_back(vertex);
+                    splitVertices.push_back(vertices[vertex]);
+                }
+                shortIndices.push_back(static_cast<uint16_t>(localIndex[vertex]));
+            }
+            current.indexCount += 3;
+        }
+        splitSubmeshes.push_back(current);
+
+        // only worth it if the duplicated vertices cost less than the index bytes saved
+        const size_t vertexSize{vertexFormat == VertexFormat::Compact ? sizeof(CompactVertex) : sizeof(Vertex)};
+        const size_t duplicatedBytes{
+            splitVertices.size() > vertices.size() ? (splitVertices.size() - vertices.size()) * vertexSize : 0};
+        const size_t savedBytes{indices.size() * (sizeof(uint32_t) - sizeof(uint16_t))};
+        if (duplicatedBytes >= savedBytes)
+        {
+            splitVertices.clear();
+            shortIndices.clear();
+            return false;
+        }
+
+        indexType = VK_INDEX_TYPE_UINT16;
+        submeshes = std::move(splitSubmeshes);
+        std::cout << "Split into " << submeshes.size() << " submeshes for 16 bit indices, "
+                  << splitVertices.size() - vertices.size() << " vertices duplicated\n";
+        return true;
+    }
+
+    std::vector<LveModel::CompactVertex> LveModel::compressVertices(
+        const std::vector<Vertex> &vertices, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+    {
+        // axes with no extent keep a unit scale so the decode stays invertible
+        glm::vec3 extent{boundsMax - boundsMin};
+        for (int i{0}; i < 3; ++i)
+        {
+            extent[i] = extent[i] > 0.f ? extent[i] : 1.f;
+        }
+        positionDecode = glm::scale(glm::translate(glm::mat4{1.f}, boundsMin), extent);
+
+        std::vector<CompactVertex> compactVertices(vertices.size());
+        float maxPositionError{0.f};
+        float maxNormalError{0.f};
+        float maxColorError{0.f};
+        float maxUvError{0.f};
+
+        for (size_t i{0}; i < vertices.size(); ++i)
+        {
+            const Vertex &vertex{vertices[i]};
+            CompactVertex &compact{compactVertices[i]};
+
+            glm::vec3 normalizedPosition{(vertex.position - boundsMin) / extent};
+            glm::vec2 octahedral{encodeOctahedral(vertex.normal)};
+            for (int c{0}; c < 3; ++c)
+            {
+                compact.position[c] = quantizeUnorm16(normalizedPosition[c]);
+                compact.color[c] = quantizeUnorm8(vertex.color[c]);
+            }
+            compact.color[3] = 255;
+            for (int c{0}; c < 2; ++c)
+            {
+                compact.normal[c] = quantizeSnorm16(octahedral[c]);
+                compact.uv[c] = glm::packHalf1x16(vertex.uv[c]);
+            }
+
+            // measure what the vertex shader will see against the float source
+            glm::vec3 decodedPosition{glm::vec3{
+                compact.position[0] / 65535.f,
+                compact.position[1] / 65535.f,
+                compact.position[2] / 65535.f}};
+            decodedPosition = boundsMin + decodedPosition * extent;
+            maxPositionError = std::max(maxPositionError, glm::length(decodedPosition - vertex.position));
+
+            float normalLength{glm::length(vertex.normal)};
+            if (normalLength > 0.f)
+            {
+                glm::vec3 decodedNormal{decodeOctahedral(glm::vec2{
+                    std::max(compact.normal[0] / 32767.f, -1.f),
+                    std::max(compact.normal[1] / 32767.f, -1.f)})};
+                float cosine{glm::clamp(glm::dot(decodedNormal, vertex.normal / normalLength), -1.f, 1.f)};
+                maxNormalError = std::max(maxNormalError, glm::degrees(std::acos(cosine)));
+            }
 
-        LveBuffer stagingBuffer{
-            lveDevice,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
+            for (int c{0}; c < 3; ++c)
+            {
+                maxColorError = std::max(
+                    maxColorError, std::abs(compact.color[c] / 255.f - glm::clamp(vertex.color[c], 0.f, 1.f)));
+            }
+            for (int c{0}; c < 2; ++c)
+            {
+                maxUvError = std::max(maxUvError, std::abs(glm::unpackHalf1x16(compact.uv[c]) - vertex.uv[c]));
+            }
+        }
+
+        std::cout << "Compact vertices: " << sizeof(Vertex) << " -> " << sizeof(CompactVertex) << " bytes, "
+                  << vertices.size() * sizeof(Vertex) / 1024.f << " -> "
+                  << compactVertices.size() * sizeof(CompactVertex) / 1024.f << " KB\n";
+        std::cout << "Quantization error: position " << maxPositionError
+                  << ", normal " << maxNormalError << " deg"
+                  << ", color " << maxColorError
+                  << ", uv " << maxUvError << "\n";
 
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer(vertices.data());
+        return compactVertices;
+    }
 
-        vertexBuffer = std::make_unique<LveBuffer>(
-            lveDevice,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    void LveModel::createVertexBuffers(const void *vertexData, uint32_t vertexSize, uint32_t count)
+    {
+        vertexCount = count;
+        this->vertexSize = vertexSize;
+        assert(vertexCount >= 3 && "Vertex count must be at least 3.");
 
-        lveDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+        vertexAllocation = geometryArena.allocateVertices(vertexData, vertexSize, vertexCount);
+        baseVertex = static_cast<int32_t>(vertexAllocation.offset / vertexSize);
     }
 
-    void LveModel::createIndexBuffers(const std::vector<uint32_t> &indices)
+    void LveModel::createIndexBuffers(const void *indexData, uint32_t indexSize, uint32_t count)
     {
-        indexCount = static_cast<uint32_t>(indices.size());
+        indexCount = count;
+        this->indexSize = indexSize;
         hasIndexBuffer = indexCount > 0;
         if (!hasIndexBuffer)
         {
             return;
         }
-        VkDeviceSize bufferSize{sizeof(indices[0]) * indexCount};
-        uint32_t indexSize{sizeof(indices[0])};
 
-        LveBuffer stagingBuffer {
-            lveDevice,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
+        indexAllocation = geometryArena.allocateIndices(indexData, indexSize, indexCount);
+        baseIndex = static_cast<uint32_t>(indexAllocation.offset / indexSize);
+    }
 
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer(indices.data());
+    void LveModel::bind(VkCommandBuffer commandBuffer)
+    {
+        BindState state{};
+        bind(commandBuffer, state);
+    }
+
+    VkDeviceSize LveModel::getGeometrySize() const
+    {
+        return static_cast<VkDeviceSize>(vertexCount) * vertexSize +
+               (hasIndexBuffer ? static_cast<VkDeviceSize>(indexCount) * indexSize : 0);
+    }
 
-        indexBuffer = std::make_unique<LveBuffer>(
-            lveDevice,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    void LveModel::evictGeometry(std::vector<char> &data)
+    {
+        assert(isResident() && "Model geometry is already evicted.");
 
-        lveDevice.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+        const VkDeviceSize vertexBytes{static_cast<VkDeviceSize>(vertexCount) * vertexSize};
+        data.resize(static_cast<size_t>(getGeometrySize()));
+        geometryArena.readBack(vertexAllocation, data.data(), vertexBytes);
+        geometryArena.free(vertexAllocation);
+        if (hasIndexBuffer)
+        {
+            geometryArena.readBack(indexAllocation, data.data() + vertexBytes, getGeometrySize() - vertexBytes);
+            geometryArena.free(indexAllocation);
+        }
     }
 
-    void LveModel::bind(VkCommandBuffer commandBuffer)
+    void LveModel::restoreGeometry(const std::vector<char> &data)
+    {
+        assert(!isResident() && "Model geometry is already resident.");
+        assert(data.size() == getGeometrySize() && "Geometry data does not belong to this model.");
+
+        createVertexBuffers(data.data(), vertexSize, vertexCount);
+        createIndexBuffers(data.data() + static_cast<size_t>(vertexCount) * vertexSize, indexSize, indexCount);
+    }
+
+    void LveModel::bind(VkCommandBuffer commandBuffer, BindState &state)
     {
-        VkBuffer buffers[] = {vertexBuffer->getBuffer()};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+        if (residencyManager != nullptr)
+        {
+            residencyManager->touch(*this);
+        }
+
+        // the buffers are bound at offset 0, draws address the model's ranges through
+        // baseVertex and baseIndex
+        VkBuffer vertexBuffer{geometryArena.getBuffer(vertexAllocation)};
+        if (vertexBuffer != state.vertexBuffer)
+        {
+            VkBuffer buffers[] = {vertexBuffer};
+            VkDeviceSize offsets[] = {0};
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+            state.vertexBuffer = vertexBuffer;
+        }
+
         if (hasIndexBuffer)
         {
-            vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+            VkBuffer indexBuffer{geometryArena.getBuffer(indexAllocation)};
+            if (indexBuffer != state.indexBuffer || indexType != state.indexType)
+            {
+                vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexType);
+                state.indexBuffer = indexBuffer;
+                state.indexType = indexType;
+            }
         }
     }
 
@@ -121,11 +406,73 @@ namespace lve
     {
         if (hasIndexBuffer)
         {
-            vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+            drawIndexRange(commandBuffer, lods[0].firstIndex, lods[0].indexCount);
         }
         else
         {
-            vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+            vkCmdDraw(commandBuffer, vertexCount, 1, static_cast<uint32_t>(baseVertex), 0);
+        }
+    }
+
+    uint32_t LveModel::drawVisible(VkCommandBuffer commandBuffer, const LveMeshletCuller &culler, uint32_t lod)
+    {
+        assert(lod < lods.size() && "Detail level out of range.");
+        const Lod &level{lods[lod]};
+        if (!hasIndexBuffer)
+        {
+            draw(commandBuffer);
+            return 0;
+        }
+        if (level.meshletCount == 0)
+        {
+            drawIndexRange(commandBuffer, level.firstIndex, level.indexCount);
+            return 0;
+        }
+
+        uint32_t visibleCount{0};
+        uint32_t runStart{0};
+        uint32_t runEnd{0};
+        for (uint32_t i{level.firstMeshlet}; i < level.firstMeshlet + level.meshletCount; ++i)
+        {
+            const LveMeshlet &meshlet{meshlets[i]};
+            if (!culler.isVisible(meshlet))
+            {
+                continue;
+            }
+            ++visibleCount;
+
+            if (runEnd > runStart && runEnd == meshlet.firstIndex)
+            {
+                runEnd += meshlet.indexCount;
+                continue;
+            }
+            if (runEnd > runStart)
+            {
+                drawIndexRange(commandBuffer, runStart, runEnd - runStart);
+            }
+            runStart = meshlet.firstIndex;
+            runEnd = meshlet.firstIndex + meshlet.indexCount;
+        }
+        if (runEnd > runStart)
+        {
+            drawIndexRange(commandBuffer, runStart, runEnd - runStart);
+        }
+        return visibleCount;
+    }
+
+    void LveModel::drawIndexRange(VkCommandBuffer commandBuffer, uint32_t firstIndex, uint32_t count)
+    {
+        // a range may cross submesh boundaries, each part is drawn with its own base vertex
+        const uint32_t lastIndex{firstIndex + count};
+        for (const auto &submesh : submeshes)
+        {
+            uint32_t begin{std::max(firstIndex, submesh.firstIndex)};
+            uint32_t end{std::min(lastIndex, submesh.firstIndex + submesh.indexCount)};
+            if (begin < end)
+            {
+                vkCmdDrawIndexed(
+                    commandBuffer, end - begin, 1, baseIndex + begin, baseVertex + submesh.vertexOffset, 0);
+            }
         }
     }
 
@@ -165,69 +512,40 @@ namespace lve
         return attributeDescriptions;
     }
 
-    void LveModel::Builder::loadModel(const std::string &filePath)
+    std::vector<VkVertexInputBindingDescription> LveModel::CompactVertex::getBindingDescriptions()
     {
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string warn;
-        std::string err;
-
-        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filePath.c_str()))
-        {
-            throw std::runtime_error(warn + err);
-        }
-
-        vertices.clear();
-        indices.clear();
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+        bindingDescriptions[0].binding = 0;
+        bindingDescriptions[0].stride = sizeof(CompactVertex);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        return bindingDescriptions;
+    }
 
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+    std::vector<VkVertexInputAttributeDescription> LveModel::CompactVertex::getAttributeDescriptions()
+    {
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(4);
 
-        for (const auto &shape : shapes)
-        {
-            for (const auto &index : shape.mesh.indices)
-            {
-                Vertex vertex{};
+        // 16 bit three component formats are rarely supported for vertex input, use four
+        attributeDescriptions[0].binding = 0;
+        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+        attributeDescriptions[0].offset = offsetof(CompactVertex, position);
 
-                if (index.vertex_index >= 0)
-                {
-                    vertex.position = {
-                        attrib.vertices[3 * index.vertex_index + 0],
-                        attrib.vertices[3 * index.vertex_index + 1],
-                        attrib.vertices[3 * index.vertex_index + 2],
-                    };
-
-                    vertex.color = {
-                        attrib.colors[3 * index.vertex_index + 0],
-                        attrib.colors[3 * index.vertex_index + 1],
-                        attrib.colors[3 * index.vertex_index + 2],
-                    };
-                }
+        attributeDescriptions[1].binding = 0;
+        attributeDescriptions[1].location = 1;
+        attributeDescriptions[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+        attributeDescriptions[1].offset = offsetof(CompactVertex, color);
 
-                if (index.normal_index >= 0)
-                {
-                    vertex.normal = {
-                        attrib.normals[3 * index.normal_index + 0],
-                        attrib.normals[3 * index.normal_index + 1],
-                        attrib.normals[3 * index.normal_index + 2],
-                    };
-                }
+        attributeDescriptions[2].binding = 0;
+        attributeDescriptions[2].location = 2;
+        attributeDescriptions[2].format = VK_FORMAT_R16G16_SNORM;
+        attributeDescriptions[2].offset = offsetof(CompactVertex, normal);
 
-                if (index.texcoord_index >= 0)
-                {
-                    vertex.uv = {
-                        attrib.texcoords[2 * index.texcoord_index + 0],
-                        attrib.texcoords[2 * index.texcoord_index + 1],
-                    };
-                }
+        attributeDescriptions[3].binding = 0;
+        attributeDescriptions[3].location = 3;
+        attributeDescriptions[3].format = VK_FORMAT_R16G16_SFLOAT;
+        attributeDescriptions[3].offset = offsetof(CompactVertex, uv);
 
-                if (uniqueVertices.count(vertex) == 0)
-                {
-                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
-                }
-                indices.push_back(uniqueVertices[vertex]);
-            }
-        }
+        return attributeDescriptions;
     }
 }
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include "lve_model.hpp"
+#include "lve_mesh_cache.hpp"
+#include "lve_mesh_optimizer.hpp"
+#include "lve_mesh_simplifier.hpp"
+#include "lve_obj_parser.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+
+namespace lve
+{
+    namespace
+    {
+        // the detail levels behind the first would mix into the figures otherwise
+        LveVertexCacheStats analyzeFullDetail(const LveModel::Builder &builder)
+        {
+            if (builder.lods.empty())
+            {
+                return LveMeshOptimizer::analyzeVertexCache(builder.indices, builder.vertices.size());
+            }
+            const auto first{builder.indices.begin() + builder.lods[0].firstIndex};
+            return LveMeshOptimizer::analyzeVertexCache(
+                std::vector<uint32_t>(first, first + builder.lods[0].indexCount), builder.vertices.size());
+        }
+
+        void computeMeshletBounds(
+            LveMeshlet &meshlet,
+            const std::vector<LveModel::Vertex> &vertices,
+            const std::vector<uint32_t> &indices)
+        {
+            const uint32_t first{meshlet.firstIndex};
+            const uint32_t last{meshlet.firstIndex + meshlet.indexCount};
+
+            // sphere around the box center, tight enough for clusters this small
+            glm::vec3 minimum{vertices[indices[first]].position};
+            glm::vec3 maximum{minimum};
+            for (uint32_t i{first}; i < last; ++i)
+            {
+                minimum = glm::min(minimum, vertices[indices[i]].position);
+                maximum = glm::max(maximum, vertices[indices[i]].position);
+            }
+            meshlet.center = (minimum + maximum) * 0.5f;
+            meshlet.radius = 0.f;
+            for (uint32_t i{first}; i < last; ++i)
+            {
+                meshlet.radius = std::max(meshlet.radius, glm::length(vertices[indices[i]].position - meshlet.center));
+            }
+
+            // normal cone over the counter-clockwise face normals, degenerate triangles skipped
+            std::array<glm::vec3, LveMeshlet::MAX_TRIANGLES> normals{};
+            std::array<glm::vec3, LveMeshlet::MAX_TRIANGLES> corners{};
+            uint32_t normalCount{0};
+            glm::vec3 axis{0.f};
+            for (uint32_t i{first}; i + 2 < last; i += 3)
+            {
+                const glm::vec3 &p0{vertices[indices[i]].position};
+                glm::vec3 normal{glm::cross(
+                    vertices[indices[i + 1]].position - p0, vertices[indices[i + 2]].position - p0)};
+                float area{glm::length(normal)};
+                if (area <= 0.f)
+                {
+                    continue;
+                }
+                normals[normalCount] = normal / area;
+                corners[normalCount] = p0;
+                axis += normals[normalCount];
+                ++normalCount;
+            }
+
+            meshlet.coneApex = meshlet.center;
+            meshlet.coneAxis = glm::vec3{0.f};
+            meshlet.coneCutoff = 1.f;
+
+            float axisLength{glm::length(axis)};
+            if (normalCount == 0 || axisLength <= 0.f)
+            {
+                return;
+            }
+            axis /= axisLength;
+
+            float minDot{1.f};
+            for (uint32_t i{0}; i < normalCount; ++i)
+            {
+                minDot = std::min(minDot, glm::dot(normals[i], axis));
+            }
+            // normals spread over a hemisphere or more, no viewpoint sees only back faces
+            if (minDot <= 0.f)
+            {
+                return;
+            }
+
+            // move the apex back along the axis until every triangle plane is in front of it
+            float maxT{0.f};
+            for (uint32_t i{0}; i < normalCount; ++i)
+            {
+                float t{glm::dot(meshlet.center - corners[i], normals[i]) / glm::dot(axis, normals[i])};
+                maxT = std::max(maxT, t);
+            }
+
+            meshlet.coneAxis = axis;
+            meshlet.coneApex = meshlet.center - axis * maxT;
+            meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+        }
+    }
+
+    bool LveModel::Builder::loadCached(
+        const std::string &filePath, bool optimize, LveVertexCacheStats *before, LveVertexCacheStats *after)
+    {
+        const uint32_t cacheFlags{optimize ? LveMeshCache::FLAG_OPTIMIZED : 0u};
+        if (LveMeshCache::load(filePath, cacheFlags, *this))
+        {
+            if (after != nullptr)
+            {
+                *after = analyzeFullDetail(*this);
+            }
+            return true;
+        }
+
+        *this = Builder{};
+        loadModel(filePath);
+        if (before != nullptr)
+        {
+            *before = analyzeFullDetail(*this);
+        }
+        if (optimize)
+        {
+            LveMeshOptimizer::optimize(*this);
+        }
+        if (after != nullptr)
+        {
+            *after = analyzeFullDetail(*this);
+        }
+        if (optimize)
+        {
+            LveMeshSimplifier::generateLods(*this);
+        }
+        buildMeshlets();
+
+        if (!LveMeshCache::store(filePath, cacheFlags, *this))
+        {
+            std::cerr << "Failed to write mesh cache: " << LveMeshCache::cachePath(filePath) << "\n";
+        }
+        return false;
+    }
+
+    void LveModel::Builder::loadModel(const std::string &filePath)
+    {
+        LveObjParser{filePath}.parse(vertices, indices);
+        computeBounds();
+    }
+
+    void LveModel::Builder::buildMeshlets()
+    {
+        meshlets.clear();
+        if (lods.empty())
+        {
+            lods.push_back(Lod{0, static_cast<uint32_t>(indices.size()), 0, 0, 0.f});
+        }
+        for (auto &lod : lods)
+        {
+            lod.firstMeshlet = static_cast<uint32_t>(meshlets.size());
+            buildMeshlets(lod.firstIndex, lod.firstIndex + lod.indexCount);
+            lod.meshletCount = static_cast<uint32_t>(meshlets.size()) - lod.firstMeshlet;
+        }
+    }
+
+    void LveModel::Builder::buildMeshlets(uint32_t firstIndex, uint32_t lastIndex)
+    {
+        const size_t firstMeshlet{meshlets.size()};
+
+        // stores the meshlet each vertex was last added to, so starting a new one needs no reset
+        std::vector<uint32_t> vertexMeshlet(vertices.size(), UINT32_MAX);
+        LveMeshlet current{};
+        current.firstIndex = firstIndex;
+        uint32_t currentVertexCount{0};
+
+        auto countNewVertices = [&](uint32_t a, uint32_t b, uint32_t c)
+        {
+            const auto meshletId{static_cast<uint32_t>(meshlets.size())};
+            return static_cast<uint32_t>(vertexMeshlet[a] != meshletId) +
+                   static_cast<uint32_t>(vertexMeshlet[b] != meshletId && b != a) +
+                   static_cast<uint32_t>(vertexMeshlet[c] != meshletId && c != a && c != b);
+        };
+
+        for (size_t i{firstIndex}; i + 2 < lastIndex; i += 3)
+        {
+            const uint32_t a{indices[i]}, b{indices[i + 1]}, c{indices[i + 2]};
+            uint32_t newVertexCount{countNewVertices(a, b, c)};
+
+            if (current.indexCount > 0 &&
+                (currentVertexCount + newVertexCount > LveMeshlet::MAX_VERTICES ||
+                 current.indexCount / 3 + 1 > LveMeshlet::MAX_TRIANGLES))
+            {
+                meshlets.push_back(current);
+                current = LveMeshlet{};
+                current.firstIndex = static_cast<uint32_t>(i);
+                currentVertexCount = 0;
+                newVertexCount = countNewVertices(a, b, c);
+            }
+
+            const auto meshletId{static_cast<uint32_t>(meshlets.size())};
+            vertexMeshlet[a] = vertexMeshlet[b] = vertexMeshlet[c] = meshletId;
+            currentVertexCount += newVertexCount;
+            current.indexCount += 3;
+        }
+        if (current.indexCount > 0)
+        {
+            meshlets.push_back(current);
+        }
+
+        for (size_t i{firstMeshlet}; i < meshlets.size(); ++i)
+        {
+            computeMeshletBounds(meshlets[i], vertices, indices);
+        }
+    }
+
+    void LveModel::Builder::computeBounds()
+    {
+        if (vertices.empty())
+        {
+            boundsMin = boundsMax = glm::vec3{0.f};
+            return;
+        }
+
+        boundsMin = boundsMax = vertices[0].position;
+        for (const auto &vertex : vertices)
+        {
+            boundsMin = glm::min(boundsMin, vertex.position);
+            boundsMax = glm::max(boundsMax, vertex.position);
+        }
+    }
+}
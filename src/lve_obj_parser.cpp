@@ -0,0 +1,413 @@
+#include "lve_obj_parser.hpp"
+#include "lve_mapped_file.hpp"
+#include "lve_vertex_table.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LVE_OBJ_PARSER_SSE2
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace lve
+{
+    namespace
+    {
+        int countTrailingZeros(uint32_t mask)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return static_cast<int>(index);
+#else
+            return __builtin_ctz(mask);
+#endif
+        }
+
+        // Scans 16 bytes per step for the line terminator; the tail is handled byte by byte.
+        const char *findLineEnd(const char *p, const char *end)
+        {
+#ifdef LVE_OBJ_PARSER_SSE2
+            const __m128i newline{_mm_set1_epi8('\n')};
+            while (end - p >= 16)
+            {
+                const __m128i chunk{_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))};
+                const int mask{_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline))};
+                if (mask != 0)
+                {
+                    return p + countTrailingZeros(static_cast<uint32_t>(mask));
+                }
+                p += 16;
+            }
+#endif
+            while (p < end && *p != '\n')
+            {
+                ++p;
+            }
+            return p;
+        }
+
+        bool isBlank(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+
+        const char *skipBlanks(const char *p, const char *end)
+        {
+            while (p < end && isBlank(*p))
+            {
+                ++p;
+            }
+            return p;
+        }
+
+        bool isDigit(char c)
+        {
+            return static_cast<unsigned char>(c - '0') < 10;
+        }
+
+        // Exactly representable powers of ten; larger exponents fall back to std::pow.
+        constexpr double POWERS_OF_TEN[]{
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+        double powerOfTen(int exponent)
+        {
+            if (exponent <= 22)
+            {
+                return POWERS_OF_TEN[exponent];
+            }
+            return std::pow(10.0, exponent);
+        }
+
+        // Locale independent decimal parser: [+-]digits[.digits][(e|E)[+-]digits].
+        // Digits are accumulated into an integer mantissa and scaled once at the end.
+        bool parseFloat(const char *&p, const char *end, float &value)
+        {
+            const char *cursor{p};
+            bool negative{false};
+            if (cursor < end && (*cursor == '-' || *cursor == '+'))
+            {
+                negative = *cursor == '-';
+                ++cursor;
+            }
+
+            uint64_t mantissa{0};
+            int exponent{0};
+            int significantDigits{0};
+            bool anyDigits{false};
+
+            while (cursor < end && isDigit(*cursor))
+            {
+                if (significantDigits < 19)
+                {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*cursor - '0');
+                    if (mantissa != 0)
+                    {
+                        ++significantDigits;
+                    }
+                }
+                else
+                {
+                    ++exponent;
+                }
+                anyDigits = true;
+                ++cursor;
+            }
+
+            if (cursor < end && *cursor == '.')
+            {
+                ++cursor;
+                while (cursor < end && isDigit(*cursor))
+                {
+                    if (significantDigits < 19)
+                    {
+                        mantissa = mantissa * 10 + static_cast<uint64_t>(*cursor - '0');
+                        --exponent;
+                        if (mantissa != 0)
+                        {
+                            ++significantDigits;
+                        }
+                    }
+                    anyDigits = true;
+                    ++cursor;
+                }
+            }
+
+            if (!anyDigits)
+            {
+                return false;
+            }
+
+            if (cursor < end && (*cursor == 'e' || *cursor == 'E'))
+            {
+                const char *exponentCursor{cursor + 1};
+                bool negativeExponent{false};
+                if (exponentCursor < end && (*exponentCursor == '-' || *exponentCursor == '+'))
+                {
+                    negativeExponent = *exponentCursor == '-';
+                    ++exponentCursor;
+                }
+                if (exponentCursor < end && isDigit(*exponentCursor))
+                {
+                    int explicitExponent{0};
+                    while (exponentCursor < end && isDigit(*exponentCursor))
+                    {
+                        if (explicitExponent < 10000)
+                        {
+                            explicitExponent = explicitExponent * 10 + (*exponentCursor - '0');
+                        }
+                        ++exponentCursor;
+                    }
+                    exponent += negativeExponent ? -explicitExponent : explicitExponent;
+                    cursor = exponentCursor;
+                }
+            }
+
+            double result{static_cast<double>(mantissa)};
+            if (exponent < 0)
+            {
+                result /= powerOfTen(-exponent);
+            }
+            else if (exponent > 0)
+            {
+                result *= powerOfTen(exponent);
+            }
+
+            value = static_cast<float>(negative ? -result : result);
+            p = cursor;
+            return true;
+        }
+
+        bool parseInt(const char *&p, const char *end, int &value)
+        {
+            const char *cursor{p};
+            bool negative{false};
+            if (cursor < end && (*cursor == '-' || *cursor == '+'))
+            {
+                negative = *cursor == '-';
+                ++cursor;
+            }
+            if (cursor >= end || !isDigit(*cursor))
+            {
+                return false;
+            }
+
+            int64_t result{0};
+            while (cursor < end && isDigit(*cursor))
+            {
+                if (result <= INT32_MAX)
+                {
+                    result = result * 10 + (*cursor - '0');
+                }
+                ++cursor;
+            }
+
+            value = static_cast<int>(std::min<int64_t>(result, INT32_MAX)) * (negative ? -1 : 1);
+            p = cursor;
+            return true;
+        }
+    }
+
+    LveObjParser::LveObjParser(const std::string &filePath) : filePath{filePath} {}
+
+    void LveObjParser::parse(std::vector<LveModel::Vertex> &vertices, std::vector<uint32_t> &indices)
+    {
+        LveMappedFile file{filePath};
+
+        vertices.clear();
+        indices.clear();
+        positions.clear();
+        colors.clear();
+        normals.clear();
+        texcoords.clear();
+        lineNumber = 0;
+
+        LveVertexTable uniqueVertices{vertices};
+
+        const char *cursor{file.data()};
+        const char *fileEnd{file.data() + file.size()};
+
+        while (cursor < fileEnd)
+        {
+            const char *lineEnd{findLineEnd(cursor, fileEnd)};
+            ++lineNumber;
+
+            const char *p{skipBlanks(cursor, lineEnd)};
+            cursor = lineEnd + 1;
+
+            const ptrdiff_t length{lineEnd - p};
+            if (length < 2)
+            {
+                continue;
+            }
+
+            if (p[0] == 'v' && isBlank(p[1]))
+            {
+                parseVertex(p + 2, lineEnd);
+            }
+            else if (length >= 3 && p[0] == 'v' && p[1] == 't' && isBlank(p[2]))
+            {
+                parseTexcoord(p + 3, lineEnd);
+            }
+            else if (length >= 3 && p[0] == 'v' && p[1] == 'n' && isBlank(p[2]))
+            {
+                parseNormal(p + 3, lineEnd);
+            }
+            else if (p[0] == 'f' && isBlank(p[1]))
+            {
+                parseFace(p + 2, lineEnd);
+
+                // resolve corners to deduplicated vertices, then fan triangulate the polygon
+                for (const auto &vertex : faceVertices)
+                {
+                    faceCorners.push_back(uniqueVertices.insert(vertex));
+                }
+                for (size_t i{1}; i + 1 < faceCorners.size(); ++i)
+                {
+                    indices.push_back(faceCorners[0]);
+                    indices.push_back(faceCorners[i]);
+                    indices.push_back(faceCorners[i + 1]);
+                }
+            }
+        }
+    }
+
+    void LveObjParser::parseVertex(const char *p, const char *end)
+    {
+        glm::vec3 position{};
+        for (int i{0}; i < 3; ++i)
+        {
+            p = skipBlanks(p, end);
+            if (!parseFloat(p, end, position[i]))
+            {
+                fail("expected vertex position");
+            }
+        }
+
+        // an optional rgb triple follows the position, anything else (e.g. w) means white
+        glm::vec3 color{1.f, 1.f, 1.f};
+        glm::vec3 parsedColor{};
+        bool hasColor{true};
+        for (int i{0}; i < 3 && hasColor; ++i)
+        {
+            p = skipBlanks(p, end);
+            hasColor = parseFloat(p, end, parsedColor[i]);
+        }
+        if (hasColor)
+        {
+            color = parsedColor;
+        }
+
+        positions.push_back(position);
+        colors.push_back(color);
+    }
+
+    void LveObjParser::parseTexcoord(const char *p, const char *end)
+    {
+        glm::vec2 texcoord{};
+        for (int i{0}; i < 2; ++i)
+        {
+            p = skipBlanks(p, end);
+            if (!parseFloat(p, end, texcoord[i]))
+            {
+                fail("expected texture coordinate");
+            }
+        }
+        texcoords.push_back(texcoord);
+    }
+
+    void LveObjParser::parseNormal(const char *p, const char *end)
+    {
+        glm::vec3 normal{};
+        for (int i{0}; i < 3; ++i)
+        {
+            p = skipBlanks(p, end);
+            if (!parseFloat(p, end, normal[i]))
+            {
+                fail("expected normal");
+            }
+        }
+        normals.push_back(normal);
+    }
+
+    void LveObjParser::parseFace(const char *p, const char *end)
+    {
+        faceVertices.clear();
+        faceCorners.clear();
+
+        while (true)
+        {
+            p = skipBlanks(p, end);
+            if (p >= end)
+            {
+                break;
+            }
+
+            LveModel::Vertex vertex{};
+
+            int positionIndex{};
+            if (!parseInt(p, end, positionIndex))
+            {
+                fail("expected face vertex index");
+            }
+            uint32_t position{resolveIndex(positionIndex, positions.size(), "vertex")};
+            vertex.position = positions[position];
+            vertex.color = colors[position];
+
+            if (p < end && *p == '/')
+            {
+                ++p;
+                int texcoordIndex{};
+                if (parseInt(p, end, texcoordIndex))
+                {
+                    vertex.uv = texcoords[resolveIndex(texcoordIndex, texcoords.size(), "texcoord")];
+                }
+                if (p < end && *p == '/')
+                {
+                    ++p;
+                    int normalIndex{};
+                    if (!parseInt(p, end, normalIndex))
+                    {
+                        fail("expected face normal index");
+                    }
+                    vertex.normal = normals[resolveIndex(normalIndex, normals.size(), "normal")];
+                }
+            }
+
+            if (p < end && !isBlank(*p))
+            {
+                fail("unexpected character in face");
+            }
+
+            faceVertices.push_back(vertex);
+        }
+
+        if (faceVertices.size() < 3)
+        {
+            fail("face has fewer than 3 vertices");
+        }
+    }
+
+    uint32_t LveObjParser::resolveIndex(int index, size_t count, const char *kind) const
+    {
+        // OBJ indices are 1-based, negative values count back from the latest element
+        int64_t resolved{index > 0 ? index - 1 : static_cast<int64_t>(count) + index};
+        if (index == 0 || resolved < 0 || resolved >= static_cast<int64_t>(count))
+        {
+            fail(std::string{kind} + " index " + std::to_string(index) + " out of range");
+        }
+        return static_cast<uint32_t>(resolved);
+    }
+
+    void LveObjParser::fail(const std::string &reason) const
+    {
+        throw std::runtime_error(
+            "Failed to parse " + filePath + ":" + std::to_string(lineNumber) + ": " + reason + ".");
+    }
+}
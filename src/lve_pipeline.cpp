@@ -19,9 +19,17 @@ namespace lve
 
     LvePipeline::~LvePipeline()
     {
-        vkDestroyShaderModule(lveDevice.device(), vertShaderModule, nullptr);
-        vkDestroyShaderModule(lveDevice.device(), fragShaderModule, nullptr);
-        vkDestroyPipeline(lveDevice.device(), graphicsPipeline, nullptr);
+        // frames in flight may still use the pipeline
+        lveDevice.deletionQueue().push(
+            [device = lveDevice.device(),
+             vertShaderModule = vertShaderModule,
+             fragShaderModule = fragShaderModule,
+             graphicsPipeline = graphicsPipeline]()
+            {
+                vkDestroyShaderModule(device, vertShaderModule, nullptr);
+                vkDestroyShaderModule(device, fragShaderModule, nullptr);
+                vkDestroyPipeline(device, graphicsPipeline, nullptr);
+            });
     }
 
     std::vector<char> LvePipeline::readFile(const std::string &filePath)
@@ -87,17 +95,14 @@ namespace lve
             return info;
         }();
 
-        auto bindingDescriptions{LveModel::Vertex::getBindingDescriptions()};
-        auto attributeDescriptions{LveModel::Vertex::getAttributeDescriptions()};
-
         auto vertexInputInfo = [&]()
         {
             VkPipelineVertexInputStateCreateInfo info{};
             info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-            info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-            info.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
-            info.pVertexAttributeDescriptions = attributeDescriptions.data();
-            info.pVertexBindingDescriptions = bindingDescriptions.data();
+            info.vertexAttributeDescriptionCount = static_cast<uint32_t>(configInfo.attributeDescriptions.size());
+            info.vertexBindingDescriptionCount = static_cast<uint32_t>(configInfo.bindingDescriptions.size());
+            info.pVertexAttributeDescriptions = configInfo.attributeDescriptions.data();
+            info.pVertexBindingDescriptions = configInfo.bindingDescriptions.data();
             return info;
         }();
 
@@ -154,6 +159,8 @@ namespace lve
 
     void LvePipeline::defaultPipelineConfigInfo(PipelineConfigInfo &configInfo)
     {
+        configInfo.bindingDescriptions = LveModel::Vertex::getBindingDescriptions();
+        configInfo.attributeDescriptions = LveModel::Vertex::getAttributeDescriptions();
 
         configInfo.viewportInfo = [&]()
         {
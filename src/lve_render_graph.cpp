@@ -0,0 +1,384 @@
+#include "lve_render_graph.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+namespace lve
+{
+    LveRenderGraph::LveRenderGraph(LveDevice &device, LveRenderer &renderer)
+        : lveDevice{device}, lveRenderer{renderer}
+    {
+    }
+
+    LveRenderGraph::~LveRenderGraph()
+    {
+        releaseCompiled();
+    }
+
+    LveRenderGraphResource LveRenderGraph::createImage(const std::string &name, const LveRenderGraphImageInfo &info)
+    {
+        compiled = false;
+        return plan.createImage(name, info);
+    }
+
+    void LveRenderGraph::addPass(
+        const std::string &name,
+        const std::function<void(PassBuilder &builder)> &setup,
+        std::function<void(VkCommandBuffer commandBuffer)> execute)
+    {
+        plan.addPass(name, setup);
+        passResources.emplace_back();
+        passResources.back().execute = std::move(execute);
+        compiled = false;
+    }
+
+    void LveRenderGraph::setBackbufferContents(VkSubpassContents contents)
+    {
+        assert(plan.getBackbufferPass() != LveRenderGraphPlan::NO_PASS && "Render graph has no backbuffer pass.");
+        plan.setContents(plan.getBackbufferPass(), contents);
+    }
+
+    void LveRenderGraph::compile()
+    {
+        releaseCompiled();
+        compiledExtent = lveRenderer.getSwapChainExtent();
+        imageResources.assign(plan.getImages().size(), ImageResources{});
+
+        plan.compile(compiledExtent, [this](LveRenderGraphResource index) { return createTransientImage(index); });
+        bindImages();
+        createRenderPasses();
+
+        const auto &passes{plan.getPasses()};
+        for (uint32_t i{0}; i < passes.size(); ++i)
+        {
+            PassResources &resources{passResources[i]};
+            resources.barriers = passes[i].barriers;
+            for (size_t j{0}; j < resources.barriers.size(); ++j)
+            {
+                resources.barriers[j].image = imageResources[passes[i].barrierImages[j]].image;
+            }
+        }
+
+        compiled = true;
+        ++version;
+        const LveRenderGraphStats &stats{plan.getStats()};
+        std::cout << "Render graph: " << stats.passCount - stats.culledPassCount << " of " << stats.passCount
+                  << " passes, " << stats.imageBarrierCount << " barriers in " << stats.barrierBatchCount
+                  << " batches, " << stats.transientImageCount << " transient images in " << stats.memorySlotCount
+                  << " allocations, " << stats.allocatedBytes / (1024.f * 1024.f) << " of "
+                  << stats.transientBytes / (1024.f * 1024.f) << " MB\n";
+    }
+
+    void LveRenderGraph::execute(VkCommandBuffer commandBuffer)
+    {
+        assert(lveRenderer.isFrameInProgress() && "Render graph must execute within a frame.");
+
+        const VkExtent2D extent{lveRenderer.getSwapChainExtent()};
+        if (!compiled || extent.width != compiledExtent.width || extent.height != compiledExtent.height)
+        {
+            compile();
+        }
+
+        const auto &passes{plan.getPasses()};
+        for (uint32_t i{0}; i < passes.size(); ++i)
+        {
+            const LveRenderGraphPlan::Pass &pass{passes[i]};
+            PassResources &resources{passResources[i]};
+            if (pass.culled)
+            {
+                continue;
+            }
+
+            if (!resources.barriers.empty())
+            {
+                vkCmdPipelineBarrier(
+                    commandBuffer,
+                    pass.srcStages,
+                    pass.dstStages,
+                    0,
+                    0,
+                    nullptr,
+                    0,
+                    nullptr,
+                    static_cast<uint32_t>(resources.barriers.size()),
+                    resources.barriers.data());
+            }
+
+            if (i == plan.getBackbufferPass())
+            {
+                lveRenderer.beginSwapChainRenderPass(commandBuffer, pass.contents);
+                resources.execute(commandBuffer);
+                lveRenderer.endSwapChainRenderPass(commandBuffer);
+                continue;
+            }
+
+            VkRenderPassBeginInfo renderPassInfo{};
+            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass = resources.renderPass;
+            renderPassInfo.framebuffer = resources.framebuffer;
+            renderPassInfo.renderArea.offset = {0, 0};
+            renderPassInfo.renderArea.extent = pass.extent;
+            renderPassInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+            renderPassInfo.pClearValues = pass.clearValues.data();
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+            VkViewport viewport{};
+            viewport.width = static_cast<float>(pass.extent.width);
+            viewport.height = static_cast<float>(pass.extent.height);
+            viewport.minDepth = 0.0f;
+            viewport.maxDepth = 1.0f;
+            VkRect2D scissor{{0, 0}, pass.extent};
+            vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+            vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+            resources.execute(commandBuffer);
+            vkCmdEndRenderPass(commandBuffer);
+        }
+    }
+
+    VkRenderPass LveRenderGraph::getRenderPass(const std::string &passName) const
+    {
+        assert(compiled && "Render graph has not been compiled.");
+        const auto &passes{plan.getPasses()};
+        for (uint32_t i{0}; i < passes.size(); ++i)
+        {
+            if (passes[i].name == passName)
+            {
+                return i == plan.getBackbufferPass() ? lveRenderer.getSwapChainRenderPass()
+                                                     : passResources[i].renderPass;
+            }
+        }
+        throw std::runtime_error("Unknown render graph pass: " + passName);
+    }
+
+    VkImageView LveRenderGraph::getImageView(LveRenderGraphResource image) const
+    {
+        assert(compiled && image < imageResources.size() && image != plan.getBackbuffer() &&
+               "Invalid render graph image.");
+        return imageResources[image].view;
+    }
+
+    VkMemoryRequirements LveRenderGraph::createTransientImage(LveRenderGraphResource index)
+    {
+        const LveRenderGraphPlan::Image &image{plan.getImages()[index]};
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = image.extent.width;
+        imageInfo.extent.height = image.extent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = image.info.format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = image.usage;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VkImage &vkImage{imageResources[index].image};
+        if (vkCreateImage(lveDevice.device(), &imageInfo, nullptr, &vkImage) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create render graph image: " + image.name);
+        }
+        VkMemoryRequirements requirements{};
+        vkGetImageMemoryRequirements(lveDevice.device(), vkImage, &requirements);
+        return requirements;
+    }
+
+    void LveRenderGraph::bindImages()
+    {
+        for (const auto &slot : plan.getSlots())
+        {
+            VkMemoryRequirements requirements{slot.size, slot.alignment, slot.memoryTypeBits};
+            slotAllocations.push_back(lveDevice.memoryAllocator().allocate(
+                requirements,
+                lveDevice.findMemoryType(slot.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+                false,
+                LveMemoryCategory::Image));
+        }
+
+        const auto &images{plan.getImages()};
+        for (LveRenderGraphResource i{0}; i < images.size(); ++i)
+        {
+            const LveRenderGraphPlan::Image &image{images[i]};
+            ImageResources &resources{imageResources[i]};
+            if (resources.image == VK_NULL_HANDLE)
+            {
+                continue;
+            }
+
+            const LveAllocation &allocation{slotAllocations[image.slot]};
+            if (vkBindImageMemory(lveDevice.device(), resources.image, allocation.memory, allocation.offset) !=
+                VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to bind render graph image memory: " + image.name);
+            }
+
+            VkImageViewCreateInfo viewInfo{};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = resources.image;
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = image.info.format;
+            viewInfo.subresourceRange.aspectMask = LveRenderGraphPlan::isDepthFormat(image.info.format)
+                                                       ? VkImageAspectFlags{VK_IMAGE_ASPECT_DEPTH_BIT}
+                                                       : VkImageAspectFlags{VK_IMAGE_ASPECT_COLOR_BIT};
+            viewInfo.subresourceRange.baseMipLevel = 0;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.baseArrayLayer = 0;
+            viewInfo.subresourceRange.layerCount = 1;
+
+            if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &resources.view) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create render graph image view: " + image.name);
+            }
+        }
+    }
+
+    // layouts only change through the graph's barriers, so every attachment starts and ends the
+    // pass in its attachment layout
+    void LveRenderGraph::createRenderPasses()
+    {
+        const auto &passes{plan.getPasses()};
+        for (uint32_t i{0}; i < passes.size(); ++i)
+        {
+            const LveRenderGraphPlan::Pass &pass{passes[i]};
+            PassResources &resources{passResources[i]};
+            if (pass.culled || i == plan.getBackbufferPass())
+            {
+                continue;
+            }
+
+            std::vector<VkAttachmentDescription> attachments{};
+            std::vector<VkAttachmentReference> colorRefs{};
+            std::vector<VkImageView> views{};
+
+            auto addAttachment = [&](LveRenderGraphResource index, VkImageLayout layout)
+            {
+                const size_t attachment{attachments.size()};
+                VkAttachmentDescription description{};
+                description.format = plan.getImages()[index].info.format;
+                description.samples = VK_SAMPLE_COUNT_1_BIT;
+                description.loadOp = pass.loadOps[attachment];
+                description.storeOp = pass.storeOps[attachment];
+                description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                description.initialLayout = layout;
+                description.finalLayout = layout;
+                attachments.push_back(description);
+                views.push_back(imageResources[index].view);
+            };
+
+            for (auto image : pass.colorWrites)
+            {
+                colorRefs.push_back(
+                    {static_cast<uint32_t>(attachments.size()), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+                addAttachment(image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+            }
+            VkAttachmentReference depthRef{};
+            if (pass.depthWrite != INVALID_RESOURCE)
+            {
+                depthRef = {static_cast<uint32_t>(attachments.size()), VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+                addAttachment(pass.depthWrite, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+            }
+
+            VkSubpassDescription subpass{};
+            subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpass.colorAttachmentCount = static_cast<uint32_t>(colorRefs.size());
+            subpass.pColorAttachments = colorRefs.data();
+            subpass.pDepthStencilAttachment = pass.depthWrite != INVALID_RESOURCE ? &depthRef : nullptr;
+
+            VkRenderPassCreateInfo renderPassInfo{};
+            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+            renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+            renderPassInfo.pAttachments = attachments.data();
+            renderPassInfo.subpassCount = 1;
+            renderPassInfo.pSubpasses = &subpass;
+
+            if (vkCreateRenderPass(lveDevice.device(), &renderPassInfo, nullptr, &resources.renderPass) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create render graph render pass: " + pass.name);
+            }
+
+            VkFramebufferCreateInfo framebufferInfo{};
+            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass = resources.renderPass;
+            framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+            framebufferInfo.pAttachments = views.data();
+            framebufferInfo.width = pass.extent.width;
+            framebufferInfo.height = pass.extent.height;
+            framebufferInfo.layers = 1;
+
+            if (vkCreateFramebuffer(lveDevice.device(), &framebufferInfo, nullptr, &resources.framebuffer) !=
+                VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create render graph framebuffer: " + pass.name);
+            }
+        }
+    }
+
+    void LveRenderGraph::releaseCompiled()
+    {
+        std::vector<VkImageView> views{};
+        std::vector<VkImage> oldImages{};
+        std::vector<VkFramebuffer> framebuffers{};
+        std::vector<VkRenderPass> renderPasses{};
+        std::vector<LveAllocation> allocations{std::move(slotAllocations)};
+        slotAllocations.clear();
+
+        for (auto &resources : imageResources)
+        {
+            if (resources.image != VK_NULL_HANDLE)
+            {
+                views.push_back(resources.view);
+                oldImages.push_back(resources.image);
+                resources.view = VK_NULL_HANDLE;
+                resources.image = VK_NULL_HANDLE;
+            }
+        }
+        for (auto &resources : passResources)
+        {
+            if (resources.renderPass != VK_NULL_HANDLE)
+            {
+                framebuffers.push_back(resources.framebuffer);
+                renderPasses.push_back(resources.renderPass);
+                resources.framebuffer = VK_NULL_HANDLE;
+                resources.renderPass = VK_NULL_HANDLE;
+            }
+        }
+        compiled = false;
+
+        if (oldImages.empty() && renderPasses.empty() && allocations.empty())
+        {
+            return;
+        }
+
+        // frames in flight may still render with them
+        lveDevice.deletionQueue().push(
+            [&device = lveDevice, views, oldImages, framebuffers, renderPasses, allocations]() mutable
+            {
+                for (auto framebuffer : framebuffers)
+                {
+                    vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
+                }
+                for (auto renderPass : renderPasses)
+                {
+                    vkDestroyRenderPass(device.device(), renderPass, nullptr);
+                }
+                for (auto view : views)
+                {
+                    vkDestroyImageView(device.device(), view, nullptr);
+                }
+                for (auto image : oldImages)
+                {
+                    vkDestroyImage(device.device(), image, nullptr);
+                }
+                for (auto &allocation : allocations)
+                {
+                    device.freeMemory(allocation);
+                }
+            });
+    }
+}
@@ -0,0 +1,475 @@
+#include "lve_render_graph_plan.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve
+{
+    namespace
+    {
+        constexpr VkAccessFlags WRITE_ACCESS{
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT};
+
+        bool hasStencil(VkFormat format)
+        {
+            return format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT ||
+                   format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+        }
+
+        VkImageAspectFlags aspectMask(VkFormat format)
+        {
+            if (!LveRenderGraphPlan::isDepthFormat(format))
+            {
+                return VK_IMAGE_ASPECT_COLOR_BIT;
+            }
+            return VK_IMAGE_ASPECT_DEPTH_BIT |
+                   (hasStencil(format) ? VkImageAspectFlags{VK_IMAGE_ASPECT_STENCIL_BIT} : VkImageAspectFlags{0});
+        }
+    }
+
+    LveRenderGraphPlan::PassBuilder &LveRenderGraphPlan::PassBuilder::writeColor(
+        LveRenderGraphResource image, VkClearColorValue clearValue)
+    {
+        assert(image < plan.images.size() && "Unknown render graph image.");
+        assert(!isDepthFormat(plan.images[image].info.format) && "Depth images are written with writeDepth.");
+        Pass &target{plan.passes[pass]};
+        assert(std::find(target.colorWrites.begin(), target.colorWrites.end(), image) == target.colorWrites.end() &&
+               "Image is already written by this pass.");
+        target.colorWrites.push_back(image);
+        target.colorClearValues.push_back(clearValue);
+        return *this;
+    }
+
+    LveRenderGraphPlan::PassBuilder &LveRenderGraphPlan::PassBuilder::writeDepth(
+        LveRenderGraphResource image, VkClearDepthStencilValue clearValue)
+    {
+        assert(image < plan.images.size() && "Unknown render graph image.");
+        assert(image != plan.backbuffer && isDepthFormat(plan.images[image].info.format) &&
+               "writeDepth needs a depth image.");
+        Pass &target{plan.passes[pass]};
+        assert(target.depthWrite == INVALID_RESOURCE && "Pass already writes a depth image.");
+        target.depthWrite = image;
+        target.depthClearValue = clearValue;
+        return *this;
+    }
+
+    LveRenderGraphPlan::PassBuilder &LveRenderGraphPlan::PassBuilder::read(LveRenderGraphResource image)
+    {
+        assert(image < plan.images.size() && "Unknown render graph image.");
+        assert(image != plan.backbuffer && "The backbuffer cannot be read by passes.");
+        plan.passes[pass].reads.push_back(image);
+        return *this;
+    }
+
+    LveRenderGraphPlan::PassBuilder &LveRenderGraphPlan::PassBuilder::setSideEffects()
+    {
+        plan.passes[pass].sideEffects = true;
+        return *this;
+    }
+
+    LveRenderGraphPlan::PassBuilder &LveRenderGraphPlan::PassBuilder::setContents(VkSubpassContents contents)
+    {
+        plan.passes[pass].contents = contents;
+        return *this;
+    }
+
+    LveRenderGraphPlan::LveRenderGraphPlan()
+    {
+        Image image{};
+        image.name = "backbuffer";
+        backbuffer = static_cast<LveRenderGraphResource>(images.size());
+        images.push_back(image);
+    }
+
+    LveRenderGraphResource LveRenderGraphPlan::createImage(const std::string &name, const LveRenderGraphImageInfo &info)
+    {
+        Image image{};
+        image.name = name;
+        image.info = info;
+        images.push_back(image);
+        return static_cast<LveRenderGraphResource>(images.size() - 1);
+    }
+
+    uint32_t LveRenderGraphPlan::addPass(const std::string &name, const std::function<void(PassBuilder &builder)> &setup)
+    {
+        assert(backbufferPass == NO_PASS && "The backbuffer pass must be the last one.");
+
+        const uint32_t index{static_cast<uint32_t>(passes.size())};
+        passes.emplace_back();
+        passes.back().name = name;
+
+        PassBuilder builder{*this, index};
+        setup(builder);
+
+        const Pass &pass{passes.back()};
+        for (auto image : pass.reads)
+        {
+            assert(std::find(pass.colorWrites.begin(), pass.colorWrites.end(), image) == pass.colorWrites.end() &&
+                   image != pass.depthWrite && "A pass cannot read an image it writes.");
+        }
+        if (std::find(pass.colorWrites.begin(), pass.colorWrites.end(), backbuffer) != pass.colorWrites.end())
+        {
+            assert(pass.colorWrites.size() == 1 && pass.depthWrite == INVALID_RESOURCE &&
+                   "The backbuffer pass renders to the swap chain's attachments only.");
+            backbufferPass = index;
+        }
+        assert((pass.contents == VK_SUBPASS_CONTENTS_INLINE || backbufferPass == index) &&
+               "Only the backbuffer pass may use secondary command buffers.");
+        return index;
+    }
+
+    void LveRenderGraphPlan::setContents(uint32_t pass, VkSubpassContents contents)
+    {
+        assert(pass < passes.size() && (contents == VK_SUBPASS_CONTENTS_INLINE || pass == backbufferPass) &&
+               "Only the backbuffer pass may use secondary command buffers.");
+        passes[pass].contents = contents;
+    }
+
+    void LveRenderGraphPlan::compile(VkExtent2D swapChainExtent, const RequirementsCallback &getRequirements)
+    {
+        stats = LveRenderGraphStats{};
+        stats.passCount = static_cast<uint32_t>(passes.size());
+
+        cullPasses();
+        packImages(swapChainExtent, getRequirements);
+        chooseAttachmentOps();
+        computeBarriers();
+    }
+
+    // walks back from the outputs, a pass is kept when a kept pass reads or loads what it writes
+    void LveRenderGraphPlan::cullPasses()
+    {
+        std::vector<bool> needed(images.size(), false);
+        for (uint32_t i{static_cast<uint32_t>(passes.size())}; i-- > 0;)
+        {
+            Pass &pass{passes[i]};
+            bool live{pass.sideEffects || i == backbufferPass ||
+                      (pass.depthWrite != INVALID_RESOURCE && needed[pass.depthWrite])};
+            for (auto image : pass.colorWrites)
+            {
+                live = live || needed[image];
+            }
+
+            pass.culled = !live;
+            if (!live)
+            {
+                ++stats.culledPassCount;
+                continue;
+            }
+
+            // writes load what earlier passes wrote, so those stay needed
+            for (auto image : pass.reads)
+            {
+                needed[image] = true;
+            }
+            for (auto image : pass.colorWrites)
+            {
+                needed[image] = true;
+            }
+            if (pass.depthWrite != INVALID_RESOURCE)
+            {
+                needed[pass.depthWrite] = true;
+            }
+        }
+    }
+
+    void LveRenderGraphPlan::packImages(VkExtent2D swapChainExtent, const RequirementsCallback &getRequirements)
+    {
+        for (auto &image : images)
+        {
+            image.usage = 0;
+            image.firstPass = NO_PASS;
+            image.lastPass = NO_PASS;
+        }
+
+        auto use = [this](LveRenderGraphResource index, uint32_t pass, VkImageUsageFlags usage)
+        {
+            Image &image{images[index]};
+            image.usage |= usage;
+            image.firstPass = std::min(image.firstPass, pass);
+            image.lastPass = image.lastPass == NO_PASS ? pass : std::max(image.lastPass, pass);
+        };
+        for (uint32_t i{0}; i < passes.size(); ++i)
+        {
+            const Pass &pass{passes[i]};
+            if (pass.culled)
+            {
+                continue;
+            }
+            for (auto image : pass.colorWrites)
+            {
+                use(image, i, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+            }
+            if (pass.depthWrite != INVALID_RESOURCE)
+            {
+                use(pass.depthWrite, i, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+            }
+            for (auto image : pass.reads)
+            {
+                use(image, i, VK_IMAGE_USAGE_SAMPLED_BIT);
+            }
+        }
+        // the backbuffer belongs to the swap chain
+        images[backbuffer].firstPass = NO_PASS;
+        images[backbuffer].lastPass = NO_PASS;
+
+        std::vector<LveRenderGraphResource> used{};
+        for (LveRenderGraphResource i{0}; i < images.size(); ++i)
+        {
+            Image &image{images[i]};
+            if (image.firstPass == NO_PASS)
+            {
+                continue;
+            }
+            used.push_back(i);
+
+            image.extent = image.info.extent.width == 0 ? swapChainExtent : image.info.extent;
+            image.requirements = getRequirements(i);
+            ++stats.transientImageCount;
+            stats.transientBytes += image.requirements.size;
+        }
+
+        // interval packing in order of first use, an image joins the first slot whose images are
+        // all done by the time it is first used
+        std::sort(
+            used.begin(),
+            used.end(),
+            [this](LveRenderGraphResource a, LveRenderGraphResource b)
+            { return images[a].firstPass < images[b].firstPass; });
+        slots.clear();
+        for (auto index : used)
+        {
+            Image &image{images[index]};
+            auto slot{std::find_if(
+                slots.begin(),
+                slots.end(),
+                [&image](const MemorySlot &slot)
+                {
+                    return slot.lastPass < image.firstPass &&
+                           (slot.memoryTypeBits & image.requirements.memoryTypeBits) != 0;
+                })};
+            if (slot == slots.end())
+            {
+                slot = slots.insert(slots.end(), MemorySlot{});
+            }
+            slot->size = std::max(slot->size, image.requirements.size);
+            slot->alignment = std::max(slot->alignment, image.requirements.alignment);
+            slot->memoryTypeBits &= image.requirements.memoryTypeBits;
+            slot->lastPass = image.lastPass;
+            image.slot = static_cast<uint32_t>(slot - slots.begin());
+        }
+
+        for (const auto &slot : slots)
+        {
+            stats.allocatedBytes += slot.size;
+        }
+        stats.memorySlotCount = static_cast<uint32_t>(slots.size());
+    }
+
+    // attachments clear on their first write of the frame and are only stored when a later pass
+    // uses them
+    void LveRenderGraphPlan::chooseAttachmentOps()
+    {
+        for (uint32_t i{0}; i < passes.size(); ++i)
+        {
+            Pass &pass{passes[i]};
+            pass.extent = VkExtent2D{0, 0};
+            pass.loadOps.clear();
+            pass.storeOps.clear();
+            pass.clearValues.clear();
+            if (pass.culled || i == backbufferPass)
+            {
+                continue;
+            }
+
+            auto addAttachment = [&](LveRenderGraphResource index, VkClearValue clearValue)
+            {
+                const Image &image{images[index]};
+                assert((pass.extent.width == 0 ||
+                        (image.extent.width == pass.extent.width && image.extent.height == pass.extent.height)) &&
+                       "Attachments of a pass must share an extent.");
+                pass.extent = image.extent;
+                pass.loadOps.push_back(isFirstWrite(i, index) ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD);
+                pass.storeOps.push_back(
+                    isUsedAfter(i, index) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE);
+                pass.clearValues.push_back(clearValue);
+            };
+
+            for (size_t j{0}; j < pass.colorWrites.size(); ++j)
+            {
+                VkClearValue clearValue{};
+                clearValue.color = pass.colorClearValues[j];
+                addAttachment(pass.colorWrites[j], clearValue);
+            }
+            if (pass.depthWrite != INVALID_RESOURCE)
+            {
+                VkClearValue clearValue{};
+                clearValue.depthStencil = pass.depthClearValue;
+                addAttachment(pass.depthWrite, clearValue);
+            }
+            if (pass.clearValues.empty())
+            {
+                throw std::runtime_error("Render graph pass writes no attachments: " + pass.name);
+            }
+        }
+    }
+
+    // replays one frame's accesses. An image's first use starts from UNDEFINED, as its contents do
+    // not survive the frame, and waits for whatever last used the memory, the previous image in
+    // its slot or the same slot in the previous frame
+    void LveRenderGraphPlan::computeBarriers()
+    {
+        struct Use
+        {
+            uint32_t pass;
+            LveRenderGraphResource image;
+            Access access;
+        };
+        std::vector<Use> uses{};
+        for (uint32_t i{0}; i < passes.size(); ++i)
+        {
+            Pass &pass{passes[i]};
+            pass.barriers.clear();
+            pass.barrierImages.clear();
+            pass.srcStages = 0;
+            pass.dstStages = 0;
+            if (pass.culled)
+            {
+                continue;
+            }
+
+            auto addUse = [&](LveRenderGraphResource image)
+            {
+                if (image != backbuffer)
+                {
+                    uses.push_back({i, image, passAccess(pass, image, !isFirstWrite(i, image))});
+                }
+            };
+            for (auto image : pass.colorWrites)
+            {
+                addUse(image);
+            }
+            if (pass.depthWrite != INVALID_RESOURCE)
+            {
+                addUse(pass.depthWrite);
+            }
+            for (auto image : pass.reads)
+            {
+                addUse(image);
+            }
+        }
+
+        std::vector<Access> slotStates(slots.size());
+        for (const auto &use : uses)
+        {
+            slotStates[images[use.image].slot] = use.access;
+        }
+
+        std::vector<Access> imageStates(images.size());
+        std::vector<bool> used(images.size(), false);
+        for (const auto &use : uses)
+        {
+            const Image &image{images[use.image]};
+            Pass &pass{passes[use.pass]};
+            const bool firstUse{!used[use.image]};
+            const Access previous{firstUse ? slotStates[image.slot] : imageStates[use.image]};
+            const VkImageLayout oldLayout{firstUse ? VK_IMAGE_LAYOUT_UNDEFINED : previous.layout};
+
+            // reads following reads in the same layout need nothing
+            if (firstUse || oldLayout != use.access.layout || (previous.access & WRITE_ACCESS) ||
+                (use.access.access & WRITE_ACCESS))
+            {
+                VkImageMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                // only writes have to be made available, reads just have to finish
+                barrier.srcAccessMask = previous.access & WRITE_ACCESS;
+                barrier.dstAccessMask = use.access.access;
+                barrier.oldLayout = oldLayout;
+                barrier.newLayout = use.access.layout;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.subresourceRange.aspectMask = aspectMask(image.info.format);
+                barrier.subresourceRange.levelCount = 1;
+                barrier.subresourceRange.layerCount = 1;
+                pass.barriers.push_back(barrier);
+                pass.barrierImages.push_back(use.image);
+                pass.srcStages |=
+                    previous.stages != 0 ? previous.stages : VkPipelineStageFlags{VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT};
+                pass.dstStages |= use.access.stages;
+            }
+
+            used[use.image] = true;
+            imageStates[use.image] = use.access;
+            slotStates[image.slot] = use.access;
+        }
+
+        for (const auto &pass : passes)
+        {
+            if (!pass.barriers.empty())
+            {
+                ++stats.barrierBatchCount;
+                stats.imageBarrierCount += static_cast<uint32_t>(pass.barriers.size());
+            }
+        }
+    }
+
+    LveRenderGraphPlan::Access LveRenderGraphPlan::passAccess(
+        const Pass &pass, LveRenderGraphResource image, bool loads) const
+    {
+        if (std::find(pass.reads.begin(), pass.reads.end(), image) != pass.reads.end())
+        {
+            return {
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT};
+        }
+        if (image == pass.depthWrite)
+        {
+            return {
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT};
+        }
+        return {
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                (loads ? VkAccessFlags{VK_ACCESS_COLOR_ATTACHMENT_READ_BIT} : VkAccessFlags{0})};
+    }
+
+    bool LveRenderGraphPlan::isFirstWrite(uint32_t pass, LveRenderGraphResource image) const
+    {
+        for (uint32_t i{0}; i < pass; ++i)
+        {
+            const Pass &earlier{passes[i]};
+            if (!earlier.culled &&
+                (earlier.depthWrite == image ||
+                 std::find(earlier.colorWrites.begin(), earlier.colorWrites.end(), image) != earlier.colorWrites.end()))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool LveRenderGraphPlan::isUsedAfter(uint32_t pass, LveRenderGraphResource image) const
+    {
+        for (uint32_t i{pass + 1}; i < passes.size(); ++i)
+        {
+            const Pass &later{passes[i]};
+            if (!later.culled &&
+                (later.depthWrite == image ||
+                 std::find(later.colorWrites.begin(), later.colorWrites.end(), image) != later.colorWrites.end() ||
+                 std::find(later.reads.begin(), later.reads.end(), image) != later.reads.end()))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool LveRenderGraphPlan::isDepthFormat(VkFormat format)
+    {
+        return format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_X8_D24_UNORM_PACK32 ||
+               format == VK_FORMAT_D32_SFLOAT || hasStencil(format);
+    }
+}
@@ -3,77 +3,188 @@
 #include <stdexcept>
 #include <iostream>
 #include <array>
+#include <algorithm>
 
 namespace lve
 {
-    LveRenderer::LveRenderer(LveWindow &window, LveDevice &device)
-        : lveWindow{window}, lveDevice{device}
+    LveRenderer::LveRenderer(
+        LveWindow &window, LveDevice &device, uint32_t workerCount, const LveFrameSettings &frameSettings)
+        : lveWindow{&window}, lveDevice{device}, workerCount{workerCount}, frameSettings{frameSettings}
     {
+        assert(!device.isHeadless() && "A headless device can only be used by a headless renderer.");
+
+        // the first swap chain is needed right away
+        recreateSwapChain();
+        while (swapChainSuspended)
+        {
+            glfwWaitEvents();
+            recreateSwapChain();
+        }
+    }
+
+    LveRenderer::LveRenderer(
+        LveDevice &device, VkExtent2D extent, uint32_t workerCount, const LveFrameSettings &frameSettings)
+        : lveWindow{nullptr},
+          lveDevice{device},
+          headlessExtent{extent},
+          workerCount{workerCount},
+          frameSettings{frameSettings}
+    {
+        assert(device.isHeadless() && "A headless renderer needs a headless device.");
+        if (extent.width == 0 || extent.height == 0)
+        {
+            throw std::runtime_error("Headless extent must not be empty.");
+        }
         recreateSwapChain();
-        createCommandBuffers();
     }
 
     LveRenderer::~LveRenderer()
     {
-        freeCommandBuffers();
+        destroyFrameContexts();
     }
 
     void LveRenderer::recreateSwapChain()
     {
-        auto extent{lveWindow.getExtent()};
-        while (extent.width == 0 || extent.height == 0)
+        auto extent{getTargetExtent()};
+        // a minimized window has nothing to present to, frames are skipped until it is restored
+        swapChainSuspended = extent.width == 0 || extent.height == 0;
+        if (swapChainSuspended)
         {
-            extent = lveWindow.getExtent();
-            glfwWaitEvents();
+            return;
         }
 
-        vkDeviceWaitIdle(lveDevice.device());
-
         if (lveSwapChain == nullptr)
         {
-            lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent);
+            lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, frameSettings);
+            std::cout << "Present mode: " << LveSwapChain::presentModeName(getPresentMode()) << std::endl;
         }
         else
         {
             std::shared_ptr<LveSwapChain> oldSwapChain {std::move(lveSwapChain)};
-            lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, oldSwapChain);
+            lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, frameSettings, oldSwapChain);
 
             if (!oldSwapChain->compareSwapFormat(*lveSwapChain.get())) {
-                throw std::runtime_error("Swap chain image (or depth) format has changed.");
+                ++swapChainFormatVersion;
+            }
+            if (oldSwapChain->getPresentMode() != getPresentMode())
+            {
+                std::cout << "Present mode: " << LveSwapChain::presentModeName(getPresentMode()) << std::endl;
+            }
+
+            // Frames in flight may still render to its framebuffers, and their presents wait on its
+            // renderFinishedSemaphores. The graphics timeline only covers the rendering, and without
+            // VK_EXT_swapchain_maintenance1 there is no fence for a present, so it is kept until as
+            // many images as either chain has frames in flight were acquired on the new chain. By
+            // then every acquire slot has waited on a frame submitted after the old chain's last
+            // present, and the queue has taken the new chain's presents queued behind it, so none
+            // of its semaphores are still waited on.
+            const uint32_t retireAfter{std::max(oldSwapChain->framesInFlight(), lveSwapChain->framesInFlight())};
+            retiredSwapChains.push_back(RetiredSwapChain{oldSwapChain, acquireCount + retireAfter});
+        }
+
+        // per-frame resources are rare to resize and may be shared by every frame, like the
+        // global descriptor set, so replacing them waits for the device
+        if (getFrameCount() != lveSwapChain->framesInFlight())
+        {
+            vkDeviceWaitIdle(lveDevice.device());
+            destroyFrameContexts();
+            createFrameContexts();
+            for (auto &callback : frameCountCallbacks)
+            {
+                callback(getFrameCount());
             }
+            std::cout << "Frames in flight: " << getFrameCount() << ", swap chain images: "
+                      << lveSwapChain->imageCount() << std::endl;
         }
     }
 
-    void LveRenderer::freeCommandBuffers()
+    void LveRenderer::setFrameSettings(const LveFrameSettings &settings)
     {
-        vkFreeCommandBuffers(
-            lveDevice.device(),
-            lveDevice.getCommandPool(),
-            static_cast<uint32_t>(commandBuffers.size()),
-            commandBuffers.data());
-        commandBuffers.clear();
+        frameSettings = settings;
+        frameSettingsChanged = true;
     }
 
-    void LveRenderer::createCommandBuffers()
+    void LveRenderer::setPresentPolicy(LvePresentPolicy policy)
     {
-        commandBuffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+        LveFrameSettings settings{frameSettings};
+        settings.presentPolicy = policy;
+        setFrameSettings(settings);
+    }
+
+    void LveRenderer::addFrameCountCallback(std::function<void(uint32_t frameCount)> callback)
+    {
+        callback(getFrameCount());
+        frameCountCallbacks.push_back(std::move(callback));
+    }
+
+    // pools are never shared between frames or threads, so each can be reset as a whole as soon
+    // as its frame's timeline value is reached, without any locking
+    void LveRenderer::createFrameContexts()
+    {
+        frames.resize(lveSwapChain->framesInFlight());
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = lveDevice.findPhysicalQueueFamilies().graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        for (auto &frame : frames)
+        {
+            if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &frame.commandPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create frame command pool.");
+            }
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = frame.commandPool;
+            allocInfo.commandBufferCount = 1;
 
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = lveDevice.getCommandPool();
-        allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+            if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &frame.commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to allocate command buffers.");
+            }
 
-        if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+            frame.workerPools.resize(workerCount);
+            for (auto &workerPool : frame.workerPools)
+            {
+                if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &workerPool.pool) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("Failed to create worker command pool.");
+                }
+            }
+        }
+    }
+
+    void LveRenderer::destroyFrameContexts()
+    {
+        // destroying a pool frees its command buffers
+        for (auto &frame : frames)
         {
-            throw std::runtime_error("Failed to allocate command buffers.");
+            for (auto &workerPool : frame.workerPools)
+            {
+                vkDestroyCommandPool(lveDevice.device(), workerPool.pool, nullptr);
+            }
+            vkDestroyCommandPool(lveDevice.device(), frame.commandPool, nullptr);
         }
+        frames.clear();
     }
 
     VkCommandBuffer LveRenderer::beginFrame()
     {
         assert(!isFrameStarted && "Can't call beginFrame while already in progress.");
 
+        if (frameSettingsChanged || swapChainSuspended)
+        {
+            frameSettingsChanged = false;
+            recreateSwapChain();
+            if (swapChainSuspended)
+            {
+                return nullptr;
+            }
+        }
+
         auto result{lveSwapChain->acquireNextImage(&currentImageIndex)};
 
         if (result == VK_ERROR_OUT_OF_DATE_KHR)
@@ -87,11 +198,33 @@ namespace lve
         };
 
         isFrameStarted = true;
+        lveDevice.deletionQueue().collect();
+
+        ++acquireCount;
+        retiredSwapChains.erase(
+            std::remove_if(
+                retiredSwapChains.begin(),
+                retiredSwapChains.end(),
+                [this](const RetiredSwapChain &retired) { return retired.releaseAcquire <= acquireCount; }),
+            retiredSwapChains.end());
+
+        // the slot's previous frame was waited on while acquiring, so none of its command buffers are in use
+        FrameContext &frame{frames[lveSwapChain->currentFrameIndex()]};
+        vkResetCommandPool(lveDevice.device(), frame.commandPool, 0);
+        for (auto &workerPool : frame.workerPools)
+        {
+            if (workerPool.usedCount > 0)
+            {
+                vkResetCommandPool(lveDevice.device(), workerPool.pool, 0);
+                workerPool.usedCount = 0;
+            }
+        }
 
         auto commandBuffer{getCurrentCommandBuffer()};
 
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
         if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
         {
@@ -112,9 +245,13 @@ namespace lve
         }
 
         auto result{lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex)};
-        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || lveWindow.wasWindowResized())
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
+            (lveWindow != nullptr && lveWindow->wasWindowResized()))
         {
-            lveWindow.resetWindowResizedFlag();
+            if (lveWindow != nullptr)
+            {
+                lveWindow->resetWindowResizedFlag();
+            }
             recreateSwapChain();
         }
         else if (result != VK_SUCCESS)
@@ -123,10 +260,9 @@ namespace lve
         }
 
         isFrameStarted = false;
-        currentFrameIndex = (currentFrameIndex + 1) % LveSwapChain::MAX_FRAMES_IN_FLIGHT;
     }
 
-    void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer)
+    void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
     {
         assert(isFrameStarted && "Can't call beginSwapChainRenderPass while frame is not in progress.");
         assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from a different frame.");
@@ -145,8 +281,68 @@ namespace lve
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+
+        // secondaries set their own, dynamic state is not inherited
+        if (contents == VK_SUBPASS_CONTENTS_INLINE)
+        {
+            setViewportAndScissor(commandBuffer);
+        }
+    }
+
+    VkCommandBuffer LveRenderer::beginSecondaryCommandBuffer(uint32_t worker)
+    {
+        assert(isFrameStarted && "Can't begin a secondary command buffer while frame is not in progress.");
+        assert(worker < workerCount && "Worker index out of range.");
+
+        WorkerCommandPool &workerPool{frames[lveSwapChain->currentFrameIndex()].workerPools[worker]};
+        if (workerPool.usedCount == workerPool.commandBuffers.size())
+        {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = workerPool.pool;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer{};
+            if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to allocate secondary command buffer.");
+            }
+            workerPool.commandBuffers.push_back(commandBuffer);
+        }
+        VkCommandBuffer commandBuffer{workerPool.commandBuffers[workerPool.usedCount++]};
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = lveSwapChain->getRenderPass();
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = lveSwapChain->getFrameBuffer(currentImageIndex);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags =
+            VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to begin recording secondary command buffer.");
+        }
+        setViewportAndScissor(commandBuffer);
+        return commandBuffer;
+    }
+
+    void LveRenderer::endSecondaryCommandBuffer(VkCommandBuffer commandBuffer)
+    {
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to record secondary command buffer.");
+        }
+    }
 
+    void LveRenderer::setViewportAndScissor(VkCommandBuffer commandBuffer)
+    {
         VkViewport viewport{};
         viewport.x = 0.0f;
         viewport.y = 0.0f;
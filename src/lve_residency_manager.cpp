@@ -0,0 +1,241 @@
+#include "lve_residency_manager.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace lve
+{
+    LveResidencyManager::LveResidencyManager(
+        LveDevice &device,
+        LveGeometryArena &geometryArena,
+        LveUploadBatcher &uploadBatcher,
+        const std::string &spillDirectory)
+        : lveDevice{device},
+          geometryArena{geometryArena},
+          uploadBatcher{uploadBatcher},
+          spillDirectory{spillDirectory}
+    {
+        if (!spillDirectory.empty())
+        {
+            std::error_code error{};
+            std::filesystem::create_directories(spillDirectory, error);
+            if (error)
+            {
+                throw std::runtime_error("Failed to create spill directory: " + spillDirectory);
+            }
+        }
+    }
+
+    // models outliving the manager are detached, evicted ones stay without geometry
+    LveResidencyManager::~LveResidencyManager()
+    {
+        for (auto &[model, entry] : entries)
+        {
+            model->setResidencyManager(nullptr);
+            if (!entry.spillPath.empty())
+            {
+                std::error_code error{};
+                std::filesystem::remove(entry.spillPath, error);
+            }
+        }
+    }
+
+    void LveResidencyManager::track(LveModel &model)
+    {
+        assert(model.isResident() && "Tracked models must start resident.");
+
+        std::lock_guard<std::mutex> lock{mutex};
+
+        // the model's own ranges are already allocated, it is only added afterwards so older
+        // models go first
+        evictToBudget(0);
+
+        // evictable right away, as it has not been drawn yet
+        Entry &entry{entries.try_emplace(&model).first->second};
+        entry.size = model.getGeometrySize();
+        model.setResidencyManager(this);
+    }
+
+    void LveResidencyManager::untrack(LveModel &model)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto it{entries.find(&model)};
+        if (it == entries.end())
+        {
+            return;
+        }
+        if (!it->second.spillPath.empty())
+        {
+            std::error_code error{};
+            std::filesystem::remove(it->second.spillPath, error);
+        }
+        model.setResidencyManager(nullptr);
+        entries.erase(it);
+    }
+
+    void LveResidencyManager::touch(LveModel &model)
+    {
+        auto it{entries.find(&model)};
+        assert(it != entries.end() && "Model is not tracked by this residency manager.");
+        Entry &entry{it->second};
+        assert(entry.resident.load(std::memory_order_acquire) && "Evicted model drawn without makeResident.");
+        // the frame being recorded takes the next value when submitted
+        entry.lastUsedFrame.store(lveDevice.graphicsTimeline().pendingValue(), std::memory_order_relaxed);
+    }
+
+    void LveResidencyManager::update()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        evictToBudget(0);
+    }
+
+    void LveResidencyManager::makeResident(LveModel &model)
+    {
+        if (model.isResident())
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        auto it{entries.find(&model)};
+        assert(it != entries.end() && "Model is not tracked by this residency manager.");
+        restore(model, it->second);
+        it->second.resident.store(true, std::memory_order_release);
+    }
+
+    LveResidencyStats LveResidencyManager::getStats()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        LveResidencyStats stats{};
+        for (const auto &[model, entry] : entries)
+        {
+            if (entry.resident.load(std::memory_order_relaxed))
+            {
+                ++stats.residentCount;
+                stats.residentBytes += entry.size;
+            }
+            else
+            {
+                ++stats.evictedCount;
+                stats.evictedBytes += entry.size;
+            }
+        }
+        stats.evictions = evictionCount;
+        stats.restores = restoreCount;
+        return stats;
+    }
+
+    // other resources count against the same heaps, so geometry gets what they leave of the budget
+    VkDeviceSize LveResidencyManager::geometryBudget()
+    {
+        VkDeviceSize budget{0};
+        VkDeviceSize usage{0};
+        for (const auto &heap : lveDevice.memoryAllocator().getHeapBudgets())
+        {
+            if (heap.deviceLocal)
+            {
+                budget += static_cast<VkDeviceSize>(heap.budget * BUDGET_USAGE_LIMIT);
+                usage += heap.usage;
+            }
+        }
+
+        const VkDeviceSize arenaSize{geometryArena.getReservedSize()};
+        const VkDeviceSize otherUsage{usage > arenaSize ? usage - arenaSize : 0};
+        return budget > otherUsage ? budget - otherUsage : 0;
+    }
+
+    void LveResidencyManager::evictToBudget(VkDeviceSize extraBytes)
+    {
+        const VkDeviceSize budget{geometryBudget()};
+        VkDeviceSize used{geometryArena.getUsedSize() + extraBytes};
+        if (used <= budget)
+        {
+            return;
+        }
+
+        const uint64_t completedFrame{lveDevice.graphicsTimeline().getCompletedValue()};
+        std::vector<std::pair<uint64_t, LveModel *>> candidates{};
+        for (const auto &[model, entry] : entries)
+        {
+            const uint64_t lastUsedFrame{entry.lastUsedFrame.load(std::memory_order_relaxed)};
+            if (entry.resident.load(std::memory_order_relaxed) && lastUsedFrame <= completedFrame)
+            {
+                candidates.emplace_back(lastUsedFrame, model);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        uint32_t evicted{0};
+        for (const auto &[lastUsedFrame, model] : candidates)
+        {
+            if (used <= budget)
+            {
+                break;
+            }
+            Entry &entry{entries[model]};
+            evict(*model, entry);
+            used -= std::min(used, entry.size);
+            ++evicted;
+        }
+
+        if (evicted > 0)
+        {
+            // freed ranges only give memory back once whole blocks are empty
+            geometryArena.trim();
+            std::cout << "Evicted " << evicted << " models, geometry " << used / (1024.f * 1024.f) << " of "
+                      << budget / (1024.f * 1024.f) << " MB budget\n";
+        }
+    }
+
+    void LveResidencyManager::evict(LveModel &model, Entry &entry)
+    {
+        model.evictGeometry(entry.data);
+        entry.resident.store(false, std::memory_order_relaxed);
+        ++evictionCount;
+
+        if (spillDirectory.empty())
+        {
+            return;
+        }
+
+        entry.spillPath = (std::filesystem::path{spillDirectory} /
+                           ("lve_residency_" + std::to_string(spillCount++) + ".bin"))
+                              .string();
+        std::ofstream file(entry.spillPath, std::ios::binary | std::ios::trunc);
+        file.write(entry.data.data(), static_cast<std::streamsize>(entry.data.size()));
+        if (!file)
+        {
+            throw std::runtime_error("Failed to write spill file: " + entry.spillPath);
+        }
+        entry.data = std::vector<char>{};
+    }
+
+    void LveResidencyManager::restore(LveModel &model, Entry &entry)
+    {
+        if (!entry.spillPath.empty())
+        {
+            entry.data.resize(static_cast<size_t>(entry.size));
+            {
+                std::ifstream file(entry.spillPath, std::ios::binary);
+                file.read(entry.data.data(), static_cast<std::streamsize>(entry.data.size()));
+                if (!file)
+                {
+                    throw std::runtime_error("Failed to read spill file: " + entry.spillPath);
+                }
+            }
+            std::error_code error{};
+            std::filesystem::remove(entry.spillPath, error);
+            entry.spillPath.clear();
+        }
+
+        model.restoreGeometry(entry.data);
+        entry.data = std::vector<char>{};
+        ++restoreCount;
+    }
+}
@@ -1,6 +1,7 @@
 #include "lve_swap_chain.hpp"
 
 // std
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -12,14 +13,18 @@
 namespace lve
 {
 
-    LveSwapChain::LveSwapChain(LveDevice &deviceRef, VkExtent2D extent)
-        : device{deviceRef}, windowExtent{extent}
+    LveSwapChain::LveSwapChain(LveDevice &deviceRef, VkExtent2D extent, const LveFrameSettings &settings)
+        : device{deviceRef}, windowExtent{extent}, settings{settings}
     {
         init();
     }
 
-    LveSwapChain::LveSwapChain(LveDevice &deviceRef, VkExtent2D extent, std::shared_ptr<LveSwapChain> previous)
-        : device{deviceRef}, windowExtent{extent}, oldSwapChain{previous}
+    LveSwapChain::LveSwapChain(
+        LveDevice &deviceRef,
+        VkExtent2D extent,
+        const LveFrameSettings &settings,
+        std::shared_ptr<LveSwapChain> previous)
+        : device{deviceRef}, windowExtent{extent}, settings{settings}, oldSwapChain{previous}
     {
         init();
 
@@ -29,7 +34,19 @@ namespace lve
 
     void LveSwapChain::init()
     {
-        createSwapChain();
+        if (settings.framesInFlight == 0)
+        {
+            throw std::runtime_error("At least one frame must be in flight.");
+        }
+
+        if (device.isHeadless())
+        {
+            createOffscreenImages();
+        }
+        else
+        {
+            createSwapChain();
+        }
         createImageViews();
         createRenderPass();
         createDepthResources();
@@ -51,11 +68,17 @@ namespace lve
             swapChain = nullptr;
         }
 
+        for (size_t i = 0; i < colorImageAllocations.size(); i++)
+        {
+            vkDestroyImage(device.device(), swapChainImages[i], nullptr);
+            device.freeMemory(colorImageAllocations[i]);
+        }
+
         for (int i = 0; i < depthImages.size(); i++)
         {
             vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
             vkDestroyImage(device.device(), depthImages[i], nullptr);
-            vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+            device.freeMemory(depthImageAllocations[i]);
         }
 
         for (auto framebuffer : swapChainFramebuffers)
@@ -66,22 +89,23 @@ namespace lve
         vkDestroyRenderPass(device.device(), renderPass, nullptr);
 
         // cleanup synchronization objects
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        for (size_t i = 0; i < settings.framesInFlight; i++)
         {
             vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
             vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
-            vkDestroyFence(device.device(), inFlightFences[i], nullptr);
         }
     }
 
     VkResult LveSwapChain::acquireNextImage(uint32_t *imageIndex)
     {
-        vkWaitForFences(
-            device.device(),
-            1,
-            &inFlightFences[currentFrame],
-            VK_TRUE,
-            std::numeric_limits<uint64_t>::max());
+        device.graphicsTimeline().wait(frameValues[currentFrame]);
+
+        if (device.isHeadless())
+        {
+            *imageIndex = nextImage;
+            nextImage = (nextImage + 1) % static_cast<uint32_t>(imageCount());
+            return VK_SUCCESS;
+        }
 
         VkResult result = vkAcquireNextImageKHR(
             device.device(),
@@ -97,14 +121,51 @@ namespace lve
     VkResult LveSwapChain::submitCommandBuffers(
         const VkCommandBuffer *buffers, uint32_t *imageIndex)
     {
-        if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE)
+        LveTimeline &timeline = device.graphicsTimeline();
+        timeline.wait(imageValues[*imageIndex]);
+        const uint64_t frameValue = timeline.nextValue();
+        frameValues[currentFrame] = frameValue;
+        imageValues[*imageIndex] = frameValue;
+
+        if (device.isHeadless())
         {
-            vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
+            VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineInfo.signalSemaphoreValueCount = 1;
+            timelineInfo.pSignalSemaphoreValues = &frameValue;
+
+            VkSubmitInfo submitInfo = {};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.pNext = &timelineInfo;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = buffers;
+
+            VkSemaphore signalSemaphore = timeline.getSemaphore();
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &signalSemaphore;
+
+            if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to submit draw command buffer!");
+            }
+
+            currentFrame = (currentFrame + 1) % settings.framesInFlight;
+            return VK_SUCCESS;
         }
-        imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
+
+        // presentation only works with binary semaphores, their values are ignored
+        uint64_t waitValues[] = {0};
+        uint64_t signalValues[] = {0, frameValue};
+        VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = 1;
+        timelineInfo.pWaitSemaphoreValues = waitValues;
+        timelineInfo.signalSemaphoreValueCount = 2;
+        timelineInfo.pSignalSemaphoreValues = signalValues;
 
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineInfo;
 
         VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
         VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
@@ -115,13 +176,11 @@ namespace lve
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = buffers;
 
-        VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-        submitInfo.signalSemaphoreCount = 1;
+        VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame], timeline.getSemaphore()};
+        submitInfo.signalSemaphoreCount = 2;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
-        vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-            VK_SUCCESS)
+        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to submit draw command buffer!");
         }
@@ -140,7 +199,7 @@ namespace lve
 
         auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
 
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        currentFrame = (currentFrame + 1) % settings.framesInFlight;
 
         return result;
     }
@@ -150,10 +209,18 @@ namespace lve
         SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
         VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-        VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+        presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
         VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
         uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+        if (settings.presentPolicy == LvePresentPolicy::PowerSaving)
+        {
+            imageCount = swapChainSupport.capabilities.minImageCount;
+        }
+        if (settings.imageCount > 0)
+        {
+            imageCount = std::max(settings.imageCount, swapChainSupport.capabilities.minImageCount);
+        }
         if (swapChainSupport.capabilities.maxImageCount > 0 &&
             imageCount > swapChainSupport.capabilities.maxImageCount)
         {
@@ -170,6 +237,13 @@ namespace lve
         createInfo.imageExtent = extent;
         createInfo.imageArrayLayers = 1;
         createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        // for readbacks, when the surface allows it
+        colorReadable =
+            (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+        if (colorReadable)
+        {
+            createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
 
         QueueFamilyIndices indices = device.findPhysicalQueueFamilies();
         uint32_t queueFamilyIndices[] = {indices.graphicsFamily, indices.presentFamily};
@@ -212,6 +286,49 @@ namespace lve
         swapChainExtent = extent;
     }
 
+    // the ring stands in for swap chain images, rendered to and then left for transfers such as
+    // readbacks instead of presentation
+    void LveSwapChain::createOffscreenImages()
+    {
+        swapChainImageFormat = device.findSupportedFormat(
+            {VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB},
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+        swapChainExtent = windowExtent;
+        // nothing waits for a vertical blank
+        presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+        colorReadable = true;
+
+        uint32_t imageCount = settings.imageCount > 0 ? settings.imageCount : settings.framesInFlight;
+        swapChainImages.resize(imageCount);
+        colorImageAllocations.resize(imageCount);
+
+        for (uint32_t i = 0; i < imageCount; i++)
+        {
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent.width = swapChainExtent.width;
+            imageInfo.extent.height = swapChainExtent.height;
+            imageInfo.extent.depth = 1;
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = swapChainImageFormat;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.flags = 0;
+
+            device.createImageWithInfo(
+                imageInfo,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                swapChainImages[i],
+                colorImageAllocations[i]);
+        }
+    }
+
     void LveSwapChain::createImageViews()
     {
         swapChainImageViews.resize(swapChainImages.size());
@@ -242,11 +359,12 @@ namespace lve
         depthAttachment.format = findDepthFormat();
         depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
         depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.storeOp =
+            settings.readableDepth ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
         depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthAttachment.finalLayout = getFinalDepthLayout();
 
         VkAttachmentReference depthAttachmentRef{};
         depthAttachmentRef.attachment = 1;
@@ -260,7 +378,7 @@ namespace lve
         colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        colorAttachment.finalLayout = getFinalLayout();
 
         VkAttachmentReference colorAttachmentRef = {};
         colorAttachmentRef.attachment = 0;
@@ -334,7 +452,7 @@ namespace lve
         VkExtent2D swapChainExtent = getSwapChainExtent();
 
         depthImages.resize(imageCount());
-        depthImageMemorys.resize(imageCount());
+        depthImageAllocations.resize(imageCount());
         depthImageViews.resize(imageCount());
 
         for (int i = 0; i < depthImages.size(); i++)
@@ -351,6 +469,10 @@ namespace lve
             imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
             imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
             imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            if (settings.readableDepth)
+            {
+                imageInfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            }
             imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
             imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
             imageInfo.flags = 0;
@@ -359,7 +481,7 @@ namespace lve
                 imageInfo,
                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                 depthImages[i],
-                depthImageMemorys[i]);
+                depthImageAllocations[i]);
 
             VkImageViewCreateInfo viewInfo{};
             viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -381,25 +503,39 @@ namespace lve
 
     void LveSwapChain::createSyncObjects()
     {
-        imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-        imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+        imageAvailableSemaphores.resize(settings.framesInFlight);
+        renderFinishedSemaphores.resize(settings.framesInFlight);
+        frameValues.resize(settings.framesInFlight, 0);
+        imageValues.resize(imageCount(), 0);
+
+        // frames submitted through the previous swap chain may still be running. With a different
+        // frame count every slot waits for the newest of them.
+        if (oldSwapChain != nullptr && oldSwapChain->settings.framesInFlight == settings.framesInFlight)
+        {
+            frameValues = oldSwapChain->frameValues;
+            currentFrame = oldSwapChain->currentFrame;
+        }
+        else if (oldSwapChain != nullptr)
+        {
+            uint64_t lastValue = *std::max_element(oldSwapChain->frameValues.begin(), oldSwapChain->frameValues.end());
+            std::fill(frameValues.begin(), frameValues.end(), lastValue);
+        }
 
         VkSemaphoreCreateInfo semaphoreInfo = {};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-        VkFenceCreateInfo fenceInfo = {};
-        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        // headless frames have no acquire or present to synchronize with
+        if (device.isHeadless())
+        {
+            return;
+        }
 
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        for (size_t i = 0; i < settings.framesInFlight; i++)
         {
             if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
                     VK_SUCCESS ||
                 vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
-                    VK_SUCCESS ||
-                vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS)
+                    VK_SUCCESS)
             {
                 throw std::runtime_error("failed to create synchronization objects for a frame!");
             }
@@ -422,28 +558,55 @@ namespace lve
     }
 
     VkPresentModeKHR LveSwapChain::chooseSwapPresentMode(
-        const std::vector<VkPresentModeKHR> &availablePresentModes)
+        const std::vector<VkPresentModeKHR> &availablePresentModes) const
     {
-        for (const auto &availablePresentMode : availablePresentModes)
+        std::vector<VkPresentModeKHR> preferred;
+        switch (settings.presentPolicy)
         {
-            if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+        case LvePresentPolicy::LowestLatency:
+            preferred = {VK_PRESENT_MODE_MAILBOX_KHR};
+            break;
+        case LvePresentPolicy::Adaptive:
+            preferred = {VK_PRESENT_MODE_FIFO_RELAXED_KHR};
+            break;
+        case LvePresentPolicy::Uncapped:
+            preferred = {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR};
+            break;
+        case LvePresentPolicy::VSync:
+        case LvePresentPolicy::PowerSaving:
+            break;
+        }
+
+        for (auto mode : preferred)
+        {
+            if (std::find(availablePresentModes.begin(), availablePresentModes.end(), mode) !=
+                availablePresentModes.end())
             {
-                std::cout << "Present mode: Mailbox" << std::endl;
-                return availablePresentMode;
+                return mode;
             }
         }
 
-        // for (const auto &availablePresentMode : availablePresentModes) {
-        //   if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-        //     std::cout << "Present mode: Immediate" << std::endl;
-        //     return availablePresentMode;
-        //   }
-        // }
-
-        std::cout << "Present mode: V-Sync" << std::endl;
+        // the only mode every surface must support
         return VK_PRESENT_MODE_FIFO_KHR;
     }
 
+    const char *LveSwapChain::presentModeName(VkPresentModeKHR mode)
+    {
+        switch (mode)
+        {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+            return "Immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+            return "Mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR:
+            return "V-Sync";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+            return "Adaptive V-Sync";
+        default:
+            return "Unknown";
+        }
+    }
+
     VkExtent2D LveSwapChain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities)
     {
         if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
@@ -0,0 +1,101 @@
+#include "lve_thread_pool.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace lve
+{
+    LveThreadPool::LveThreadPool(uint32_t workerCount)
+    {
+        assert(workerCount > 0 && "Thread pool needs at least one worker.");
+
+        workers.reserve(workerCount);
+        for (uint32_t i{0}; i < workerCount; ++i)
+        {
+            workers.emplace_back(&LveThreadPool::workerLoop, this, i);
+        }
+    }
+
+    LveThreadPool::~LveThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stopping = true;
+        }
+        wakeCondition.notify_all();
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    uint32_t LveThreadPool::defaultWorkerCount()
+    {
+        // hardware_concurrency may report 0 when unknown
+        return std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    void LveThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t index, uint32_t worker)> &task)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock{mutex};
+        assert(this->task == nullptr && "parallelFor is not reentrant.");
+        this->task = &task;
+        taskCount = count;
+        nextTask = 0;
+        pendingTasks = count;
+        error = nullptr;
+        wakeCondition.notify_all();
+
+        doneCondition.wait(lock, [this]() { return pendingTasks == 0; });
+        this->task = nullptr;
+        taskCount = 0;
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void LveThreadPool::workerLoop(uint32_t worker)
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        while (true)
+        {
+            wakeCondition.wait(lock, [this]() { return stopping || nextTask < taskCount; });
+            if (stopping)
+            {
+                return;
+            }
+
+            while (nextTask < taskCount)
+            {
+                const uint32_t index{nextTask++};
+                lock.unlock();
+                try
+                {
+                    (*task)(index, worker);
+                }
+                catch (...)
+                {
+                    lock.lock();
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                    lock.unlock();
+                }
+                lock.lock();
+
+                if (--pendingTasks == 0)
+                {
+                    doneCondition.notify_one();
+                }
+            }
+        }
+    }
+}
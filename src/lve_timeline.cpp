@@ -0,0 +1,81 @@
+#include "lve_timeline.hpp"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace lve
+{
+    LveTimeline::LveTimeline(
+        VkDevice device,
+        PFN_vkGetSemaphoreCounterValue getCounterValue,
+        PFN_vkWaitSemaphores waitSemaphores)
+        : device{device}, getCounterValue{getCounterValue}, waitSemaphores{waitSemaphores}
+    {
+        VkSemaphoreTypeCreateInfo typeInfo{};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &typeInfo;
+        if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create timeline semaphore.");
+        }
+    }
+
+    LveTimeline::~LveTimeline() { vkDestroySemaphore(device, semaphore, nullptr); }
+
+    uint64_t LveTimeline::getCompletedValue()
+    {
+        uint64_t value{0};
+        if (getCounterValue(device, semaphore, &value) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to query timeline semaphore.");
+        }
+        updateCompletedValue(value);
+        return value;
+    }
+
+    bool LveTimeline::isComplete(uint64_t value)
+    {
+        return value <= completedValue.load(std::memory_order_acquire) || value <= getCompletedValue();
+    }
+
+    bool LveTimeline::wait(uint64_t value, uint64_t timeout)
+    {
+        assert(value <= submittedValue && "Waiting for a timeline value no submission signals.");
+        if (value <= completedValue.load(std::memory_order_acquire))
+        {
+            return true;
+        }
+
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &semaphore;
+        waitInfo.pValues = &value;
+        VkResult result{waitSemaphores(device, &waitInfo, timeout)};
+        if (result == VK_TIMEOUT)
+        {
+            return false;
+        }
+        if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to wait for timeline semaphore.");
+        }
+        updateCompletedValue(value);
+        return true;
+    }
+
+    // several threads may poll at once, the cached value only moves forward
+    void LveTimeline::updateCompletedValue(uint64_t value)
+    {
+        uint64_t known{completedValue.load(std::memory_order_relaxed)};
+        while (known < value &&
+               !completedValue.compare_exchange_weak(known, value, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+}
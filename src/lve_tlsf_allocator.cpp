@@ -0,0 +1,272 @@
+#include "lve_tlsf_allocator.hpp"
+
+#include <cassert>
+
+namespace lve
+{
+    namespace
+    {
+        uint32_t highestBit(uint64_t value)
+        {
+            uint32_t bit{0};
+            while (value >>= 1)
+            {
+                ++bit;
+            }
+            return bit;
+        }
+
+        uint32_t lowestBit(uint64_t value)
+        {
+            uint32_t bit{0};
+            while ((value & 1) == 0)
+            {
+                value >>= 1;
+                ++bit;
+            }
+            return bit;
+        }
+    }
+
+    LveTlsfAllocator::LveTlsfAllocator(uint64_t capacity) : capacity{capacity}, freeSize{0}
+    {
+        for (auto &heads : freeHeads)
+        {
+            for (auto &head : heads)
+            {
+                head = INVALID_NODE;
+            }
+        }
+
+        if (capacity > 0)
+        {
+            uint32_t node{createNode()};
+            nodes[node].size = capacity;
+            insertFree(node);
+        }
+    }
+
+    // sizes below SL_COUNT map linearly into the first row, larger ones by highest bit and the
+    // SL_LOG2 bits below it
+    void LveTlsfAllocator::mapping(uint64_t size, uint32_t &fl, uint32_t &sl)
+    {
+        if (size < SL_COUNT)
+        {
+            fl = 0;
+            sl = static_cast<uint32_t>(size);
+            return;
+        }
+        uint32_t bit{highestBit(size)};
+        fl = bit - SL_LOG2 + 1;
+        sl = static_cast<uint32_t>(size >> (bit - SL_LOG2)) ^ SL_COUNT;
+    }
+
+    uint32_t LveTlsfAllocator::findFree(uint64_t size) const
+    {
+        // round up to the next bin boundary so any range in the found bin is large enough
+        uint64_t searchSize{size};
+        if (size >= SL_COUNT)
+        {
+            uint64_t round{(uint64_t{1} << (highestBit(size) - SL_LOG2)) - 1};
+            searchSize = size > UINT64_MAX - round ? UINT64_MAX : size + round;
+        }
+
+        uint32_t fl{0}, sl{0};
+        mapping(searchSize, fl, sl);
+        if (fl < FL_COUNT)
+        {
+            uint32_t slMap{slBitmaps[fl] & (~0u << sl)};
+            if (slMap == 0)
+            {
+                uint64_t flMap{fl + 1 < 64 ? flBitmap & (~uint64_t{0} << (fl + 1)) : 0};
+                if (flMap != 0)
+                {
+                    fl = lowestBit(flMap);
+                    slMap = slBitmaps[fl];
+                }
+            }
+            if (slMap != 0)
+            {
+                return freeHeads[fl][lowestBit(slMap)];
+            }
+        }
+
+        // the bin of size itself may still hold a range that fits, which matters when the
+        // request is close to the whole capacity
+        mapping(size, fl, sl);
+        for (uint32_t node{freeHeads[fl][sl]}; node != INVALID_NODE; node = nodes[node].nextFree)
+        {
+            if (nodes[node].size >= size)
+            {
+                return node;
+            }
+        }
+        return INVALID_NODE;
+    }
+
+    uint32_t LveTlsfAllocator::allocate(uint64_t size, uint64_t &offset, uint64_t alignment)
+    {
+        assert(size > 0 && "Cannot allocate an empty range.");
+        assert(alignment > 0 && "Alignment must not be zero.");
+
+        // any range this large has an aligned start with size units behind it
+        const uint64_t paddedSize{size + alignment - 1};
+        if (paddedSize < size)
+        {
+            return INVALID_NODE;
+        }
+        uint32_t node{findFree(paddedSize)};
+        if (node == INVALID_NODE)
+        {
+            return INVALID_NODE;
+        }
+        removeFree(node);
+
+        // the gap before the aligned start stays free as its own range, its physical predecessor
+        // is never free since free neighbours are always merged
+        const uint64_t padding{(alignment - nodes[node].offset % alignment) % alignment};
+        if (padding > 0)
+        {
+            uint32_t gap{createNode()};
+            Node &aligned{nodes[node]};
+            nodes[gap].offset = aligned.offset;
+            nodes[gap].size = padding;
+            nodes[gap].prevPhysical = aligned.prevPhysical;
+            nodes[gap].nextPhysical = node;
+            if (aligned.prevPhysical != INVALID_NODE)
+            {
+                nodes[aligned.prevPhysical].nextPhysical = gap;
+            }
+            aligned.prevPhysical = gap;
+            aligned.offset += padding;
+            aligned.size -= padding;
+            insertFree(gap);
+        }
+
+        // the tail goes back to the free lists as its own range
+        if (nodes[node].size > size)
+        {
+            uint32_t tail{createNode()};
+            Node &head{nodes[node]};
+            nodes[tail].offset = head.offset + size;
+            nodes[tail].size = head.size - size;
+            nodes[tail].prevPhysical = node;
+            nodes[tail].nextPhysical = head.nextPhysical;
+            if (head.nextPhysical != INVALID_NODE)
+            {
+                nodes[head.nextPhysical].prevPhysical = tail;
+            }
+            head.nextPhysical = tail;
+            head.size = size;
+            insertFree(tail);
+        }
+
+        offset = nodes[node].offset;
+        return node;
+    }
+
+    void LveTlsfAllocator::free(uint32_t node)
+    {
+        assert(node < nodes.size() && !nodes[node].free && "Range is not allocated.");
+
+        uint32_t prev{nodes[node].prevPhysical};
+        if (prev != INVALID_NODE && nodes[prev].free)
+        {
+            removeFree(prev);
+            nodes[prev].size += nodes[node].size;
+            nodes[prev].nextPhysical = nodes[node].nextPhysical;
+            if (nodes[node].nextPhysical != INVALID_NODE)
+            {
+                nodes[nodes[node].nextPhysical].prevPhysical = prev;
+            }
+            releaseNode(node);
+            node = prev;
+        }
+
+        uint32_t next{nodes[node].nextPhysical};
+        if (next != INVALID_NODE && nodes[next].free)
+        {
+            removeFree(next);
+            nodes[node].size += nodes[next].size;
+            nodes[node].nextPhysical = nodes[next].nextPhysical;
+            if (nodes[next].nextPhysical != INVALID_NODE)
+            {
+                nodes[nodes[next].nextPhysical].prevPhysical = node;
+            }
+            releaseNode(next);
+        }
+
+        insertFree(node);
+    }
+
+    uint32_t LveTlsfAllocator::createNode()
+    {
+        if (!unusedNodes.empty())
+        {
+            uint32_t node{unusedNodes.back()};
+            unusedNodes.pop_back();
+            nodes[node] = Node{};
+            return node;
+        }
+        nodes.push_back(Node{});
+        return static_cast<uint32_t>(nodes.size() - 1);
+    }
+
+    void LveTlsfAllocator::releaseNode(uint32_t node)
+    {
+        unusedNodes.push_back(node);
+    }
+
+    void LveTlsfAllocator::insertFree(uint32_t node)
+    {
+        uint32_t fl{0}, sl{0};
+        mapping(nodes[node].size, fl, sl);
+
+        uint32_t &head{freeHeads[fl][sl]};
+        nodes[node].free = true;
+        nodes[node].prevFree = INVALID_NODE;
+        nodes[node].nextFree = head;
+        if (head != INVALID_NODE)
+        {
+            nodes[head].prevFree = node;
+        }
+        head = node;
+
+        flBitmap |= uint64_t{1} << fl;
+        slBitmaps[fl] |= 1u << sl;
+        freeSize += nodes[node].size;
+    }
+
+    void LveTlsfAllocator::removeFree(uint32_t node)
+    {
+        uint32_t fl{0}, sl{0};
+        mapping(nodes[node].size, fl, sl);
+
+        Node &entry{nodes[node]};
+        if (entry.prevFree != INVALID_NODE)
+        {
+            nodes[entry.prevFree].nextFree = entry.nextFree;
+        }
+        else
+        {
+            freeHeads[fl][sl] = entry.nextFree;
+        }
+        if (entry.nextFree != INVALID_NODE)
+        {
+            nodes[entry.nextFree].prevFree = entry.prevFree;
+        }
+
+        if (freeHeads[fl][sl] == INVALID_NODE)
+        {
+            slBitmaps[fl] &= ~(1u << sl);
+            if (slBitmaps[fl] == 0)
+            {
+                flBitmap &= ~(uint64_t{1} << fl);
+            }
+        }
+
+        entry.free = false;
+        entry.prevFree = entry.nextFree = INVALID_NODE;
+        freeSize -= entry.size;
+    }
+}
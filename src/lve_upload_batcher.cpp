@@ -0,0 +1,375 @@
+#include "lve_upload_batcher.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve
+{
+    LveUploadBatcher::LveUploadBatcher(LveDevice &device) : lveDevice{device}
+    {
+        QueueFamilyIndices queueFamilies{lveDevice.findPhysicalQueueFamilies()};
+        transferFamily = queueFamilies.transferFamily;
+        graphicsFamily = queueFamilies.graphicsFamily;
+        ownershipTransfer = queueFamilies.hasDedicatedTransfer();
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = transferFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create upload command pool.");
+        }
+        if (ownershipTransfer)
+        {
+            poolInfo.queueFamilyIndex = graphicsFamily;
+            if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &acquireCommandPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create upload acquire command pool.");
+            }
+        }
+
+        stagingBuffer = std::make_unique<LveBuffer>(
+            lveDevice,
+            STAGING_SIZE,
+            1,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if (stagingBuffer->map() != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to map upload staging buffer.");
+        }
+        stagingData = static_cast<char *>(stagingBuffer->getMappedMemory());
+    }
+
+    LveUploadBatcher::~LveUploadBatcher()
+    {
+        waitIdle();
+        if (ownershipTransfer)
+        {
+            // acquires are only known to be done once a later frame completes, which may never come
+            vkQueueWaitIdle(lveDevice.graphicsQueue());
+        }
+        // frees the batches' command buffers
+        vkDestroyCommandPool(lveDevice.device(), commandPool, nullptr);
+        if (acquireCommandPool != VK_NULL_HANDLE)
+        {
+            vkDestroyCommandPool(lveDevice.device(), acquireCommandPool, nullptr);
+        }
+    }
+
+    LveUploadHandle LveUploadBatcher::upload(
+        VkBuffer dstBuffer, VkDeviceSize dstOffset, const void *data, VkDeviceSize size)
+    {
+        // copies larger than half the ring are split so a chunk always fits next to another batch
+        const VkDeviceSize maxChunk{STAGING_SIZE / 2};
+        const auto *bytes{static_cast<const char *>(data)};
+        for (VkDeviceSize done{0}; done < size;)
+        {
+            VkDeviceSize chunk{std::min(size - done, maxChunk)};
+            VkDeviceSize stagingOffset{reserveStaging(chunk)};
+            if (!recording)
+            {
+                beginBatch();
+            }
+
+            std::memcpy(stagingData + stagingOffset, bytes + done, static_cast<size_t>(chunk));
+
+            VkBufferCopy copyRegion{};
+            copyRegion.srcOffset = stagingOffset;
+            copyRegion.dstOffset = dstOffset + done;
+            copyRegion.size = chunk;
+            vkCmdCopyBuffer(current.commandBuffer, stagingBuffer->getBuffer(), dstBuffer, 1, &copyRegion);
+            current.stagingEnd = stagingHead;
+            if (ownershipTransfer)
+            {
+                addOwnershipBarrier(dstBuffer, copyRegion.dstOffset, chunk);
+            }
+
+            done += chunk;
+        }
+
+        return LveUploadHandle{recording ? current.id : completedBatchId};
+    }
+
+    VkDeviceSize LveUploadBatcher::reserveStaging(VkDeviceSize size)
+    {
+        assert(size <= STAGING_SIZE / 2 && "Staging chunk does not fit the ring.");
+
+        // data never wraps around the ring end, the remainder is skipped instead
+        uint64_t start{(stagingHead + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1)};
+        if (start % STAGING_SIZE + size > STAGING_SIZE)
+        {
+            start += STAGING_SIZE - start % STAGING_SIZE;
+        }
+
+        while (start + size - stagingTail > STAGING_SIZE)
+        {
+            // the space may be held by the batch being recorded, which must be submitted first
+            if (inFlight.empty())
+            {
+                assert(recording && "Staging ring is full without batches in flight.");
+                flush();
+                continue;
+            }
+            retireOldest();
+        }
+
+        stagingHead = start + size;
+        return start % STAGING_SIZE;
+    }
+
+    void LveUploadBatcher::beginBatch()
+    {
+        // a retired batch's acquire may still be pending on the graphics queue, new buffers are
+        // cheaper than waiting for the next frame
+        auto idle{std::find_if(idleBatches.begin(), idleBatches.end(), [this](const Batch &batch) {
+            return !ownershipTransfer || lveDevice.graphicsTimeline().isComplete(batch.acquireFrame);
+        })};
+        if (idle != idleBatches.end())
+        {
+            current = *idle;
+            idleBatches.erase(idle);
+        }
+        else
+        {
+            current = Batch{};
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = commandPool;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &current.commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to allocate upload command buffer.");
+            }
+
+            if (ownershipTransfer)
+            {
+                allocInfo.commandPool = acquireCommandPool;
+                if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &current.acquireCommandBuffer) !=
+                    VK_SUCCESS)
+                {
+                    throw std::runtime_error("Failed to allocate upload acquire command buffer.");
+                }
+            }
+        }
+
+        current.id = lveDevice.transferTimeline().pendingValue();
+        current.stagingEnd = stagingHead;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(current.commandBuffer, &beginInfo);
+        recording = true;
+    }
+
+    void LveUploadBatcher::addOwnershipBarrier(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+    {
+        if (!ownershipBarriers.empty())
+        {
+            VkBufferMemoryBarrier &last{ownershipBarriers.back()};
+            if (last.buffer == buffer && last.offset + last.size == offset)
+            {
+                last.size += size;
+                return;
+            }
+        }
+
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = transferFamily;
+        barrier.dstQueueFamilyIndex = graphicsFamily;
+        barrier.buffer = buffer;
+        barrier.offset = offset;
+        barrier.size = size;
+        ownershipBarriers.push_back(barrier);
+    }
+
+    void LveUploadBatcher::submitBatch()
+    {
+        if (ownershipTransfer)
+        {
+            // releases to the graphics family, the acquire makes the writes available there
+            for (auto &barrier : ownershipBarriers)
+            {
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = 0;
+            }
+            vkCmdPipelineBarrier(
+                current.commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0,
+                nullptr,
+                static_cast<uint32_t>(ownershipBarriers.size()),
+                ownershipBarriers.data(),
+                0,
+                nullptr);
+        }
+        else
+        {
+            // later submissions on the queue may read the uploaded ranges as vertex input
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask =
+                VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+            vkCmdPipelineBarrier(
+                current.commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                1,
+                &barrier,
+                0,
+                nullptr,
+                0,
+                nullptr);
+        }
+        vkEndCommandBuffer(current.commandBuffer);
+
+        LveTimeline &timeline{lveDevice.transferTimeline()};
+        const uint64_t value{timeline.nextValue()};
+        assert(value == current.id && "Only one upload batcher may signal the transfer timeline.");
+        const VkSemaphore semaphore{timeline.getSemaphore()};
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.signalSemaphoreValueCount = 1;
+        timelineInfo.pSignalSemaphoreValues = &value;
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &current.commandBuffer;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &semaphore;
+        if (vkQueueSubmit(lveDevice.transferQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to submit upload batch.");
+        }
+    }
+
+    // the acquire barriers must describe the same ranges as the release, only their access masks differ
+    void LveUploadBatcher::submitOwnershipAcquire()
+    {
+        // graphics queue stages that may read uploaded ranges, vertex input for draws and transfer
+        // for readbacks
+        const VkPipelineStageFlags consumerStages{VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT};
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(current.acquireCommandBuffer, &beginInfo);
+
+        for (auto &barrier : ownershipBarriers)
+        {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask =
+                VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+        }
+        // starts at the stages the timeline wait blocks, which chains it to the release
+        vkCmdPipelineBarrier(
+            current.acquireCommandBuffer,
+            consumerStages,
+            consumerStages,
+            0,
+            0,
+            nullptr,
+            static_cast<uint32_t>(ownershipBarriers.size()),
+            ownershipBarriers.data(),
+            0,
+            nullptr);
+        vkEndCommandBuffer(current.acquireCommandBuffer);
+        ownershipBarriers.clear();
+
+        const VkSemaphore semaphore{lveDevice.transferTimeline().getSemaphore()};
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = 1;
+        timelineInfo.pWaitSemaphoreValues = &current.id;
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &semaphore;
+        submitInfo.pWaitDstStageMask = &consumerStages;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &current.acquireCommandBuffer;
+        if (vkQueueSubmit(lveDevice.graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to submit upload acquire.");
+        }
+        // the acquire signals nothing, the next frame submitted after it does
+        current.acquireFrame = lveDevice.graphicsTimeline().pendingValue();
+    }
+
+    void LveUploadBatcher::flush()
+    {
+        if (recording)
+        {
+            submitBatch();
+            if (ownershipTransfer)
+            {
+                submitOwnershipAcquire();
+            }
+            inFlight.push_back(current);
+            recording = false;
+        }
+        retireCompleted();
+    }
+
+    bool LveUploadBatcher::isComplete(LveUploadHandle handle)
+    {
+        retireCompleted();
+        return handle.batch <= completedBatchId;
+    }
+
+    void LveUploadBatcher::wait(LveUploadHandle handle)
+    {
+        if (recording && handle.batch >= current.id)
+        {
+            flush();
+        }
+        while (handle.batch > completedBatchId && !inFlight.empty())
+        {
+            retireOldest();
+        }
+    }
+
+    void LveUploadBatcher::waitIdle()
+    {
+        flush();
+        while (!inFlight.empty())
+        {
+            retireOldest();
+        }
+    }
+
+    void LveUploadBatcher::retireCompleted()
+    {
+        while (!inFlight.empty() && lveDevice.transferTimeline().isComplete(inFlight.front().id))
+        {
+            retireOldest();
+        }
+    }
+
+    void LveUploadBatcher::retireOldest()
+    {
+        Batch batch{inFlight.front()};
+        inFlight.pop_front();
+        lveDevice.transferTimeline().wait(batch.id);
+
+        completedBatchId = batch.id;
+        stagingTail = batch.stagingEnd;
+        idleBatches.push_back(batch);
+    }
+}
@@ -0,0 +1,140 @@
+#include "lve_vertex_table.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+namespace lve
+{
+    namespace
+    {
+        constexpr uint32_t NEGATIVE_ZERO_BITS{0x80000000u};
+
+        static_assert(sizeof(LveModel::Vertex) % sizeof(uint32_t) == 0, "Vertex must be made of 32 bit floats.");
+
+        template <size_t N>
+        void loadWords(const LveModel::Vertex &vertex, uint32_t (&words)[N])
+        {
+            std::memcpy(words, &vertex, sizeof(words));
+            for (auto &word : words)
+            {
+                word = word == NEGATIVE_ZERO_BITS ? 0 : word;
+            }
+        }
+
+        // Multiply-rotate hash over the vertex words, folded down to 32 bits.
+        template <size_t N>
+        uint32_t hashWords(const uint32_t (&words)[N])
+        {
+            uint64_t hash{0};
+            for (auto word : words)
+            {
+                hash = ((hash << 5) | (hash >> 59)) ^ word;
+                hash *= 0x9E3779B97F4A7C15ull;
+            }
+            return static_cast<uint32_t>(hash ^ (hash >> 32));
+        }
+    }
+
+    LveVertexTable::LveVertexTable(std::vector<LveModel::Vertex> &vertices, size_t expectedVertexCount)
+        : vertices{vertices}
+    {
+        size_t slotCount{16};
+        while (slotCount * 3 < expectedVertexCount * 4)
+        {
+            slotCount *= 2;
+        }
+        assert(vertices.empty() && "Vertex array must be empty when the table is created.");
+        rehash(slotCount);
+    }
+
+    uint32_t LveVertexTable::insert(const LveModel::Vertex &vertex)
+    {
+        uint32_t words[WORD_COUNT];
+        loadWords(vertex, words);
+        uint32_t hash{hashWords(words)};
+
+        // keep the load factor at or below 3/4
+        if ((count + 1) * 4 > slots.size() * 3)
+        {
+            rehash(slots.size() * 2);
+        }
+
+        size_t position{hash & mask};
+        size_t distance{0};
+        while (true)
+        {
+            Slot &slot{slots[position]};
+            size_t slotDistance{(position - (slot.hash & mask)) & mask};
+
+            // an empty slot or a slot closer to its home than we are ends the probe: the vertex is new
+            if (slot.index == EMPTY || slotDistance < distance)
+            {
+                auto index{static_cast<uint32_t>(vertices.size())};
+                vertices.push_back(vertex);
+                ++count;
+
+                Slot displaced{slot};
+                slot = Slot{hash, index};
+                if (displaced.index != EMPTY)
+                {
+                    place(displaced, (position + 1) & mask, slotDistance + 1);
+                }
+                return index;
+            }
+
+            if (slot.hash == hash && matches(words, slot.index))
+            {
+                return slot.index;
+            }
+
+            position = (position + 1) & mask;
+            ++distance;
+        }
+    }
+
+    void LveVertexTable::rehash(size_t slotCount)
+    {
+        std::vector<Slot> oldSlots(slotCount);
+        std::swap(slots, oldSlots);
+        mask = slotCount - 1;
+
+        for (const auto &slot : oldSlots)
+        {
+            if (slot.index != EMPTY)
+            {
+                place(slot, slot.hash & mask, 0);
+            }
+        }
+    }
+
+    void LveVertexTable::place(Slot slot, size_t position, size_t distance)
+    {
+        while (true)
+        {
+            Slot &current{slots[position]};
+            if (current.index == EMPTY)
+            {
+                current = slot;
+                return;
+            }
+
+            size_t currentDistance{(position - (current.hash & mask)) & mask};
+            if (currentDistance < distance)
+            {
+                std::swap(slot, current);
+                distance = currentDistance;
+            }
+
+            position = (position + 1) & mask;
+            ++distance;
+        }
+    }
+
+    bool LveVertexTable::matches(const uint32_t (&words)[WORD_COUNT], uint32_t index) const
+    {
+        uint32_t candidate[WORD_COUNT];
+        loadWords(vertices[index], candidate);
+        return std::memcmp(words, candidate, sizeof(candidate)) == 0;
+    }
+}
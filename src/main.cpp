@@ -3,11 +3,58 @@
 // std
 #include <cstdlib>
 #include <iostream>
+#include <map>
 #include <stdexcept>
+#include <string>
 
-int main()
+int main(int argc, char **argv)
 {
-    lve::FirstApp app{};
+    const std::map<std::string, lve::LvePresentPolicy> presentPolicies{
+        {"latency", lve::LvePresentPolicy::LowestLatency},
+        {"vsync", lve::LvePresentPolicy::VSync},
+        {"adaptive", lve::LvePresentPolicy::Adaptive},
+        {"power", lve::LvePresentPolicy::PowerSaving},
+        {"uncapped", lve::LvePresentPolicy::Uncapped},
+    };
+
+    // --frames-in-flight 1 for the lowest latency, 3 for throughput
+    lve::LveFrameSettings frameSettings{};
+    // --headless 1000 renders that many frames offscreen, without a window
+    uint32_t headlessFrameCount{0};
+    // --capture frames writes every frame there as a PNG
+    std::string captureDirectory{};
+    for (int i{1}; i + 1 < argc; i += 2)
+    {
+        std::string option{argv[i]};
+        auto value{static_cast<uint32_t>(std::strtoul(argv[i + 1], nullptr, 10))};
+        if (option == "--present" && presentPolicies.count(argv[i + 1]) > 0)
+        {
+            frameSettings.presentPolicy = presentPolicies.at(argv[i + 1]);
+        }
+        else if (option == "--frames-in-flight")
+        {
+            frameSettings.framesInFlight = value;
+        }
+        else if (option == "--swap-chain-images")
+        {
+            frameSettings.imageCount = value;
+        }
+        else if (option == "--capture")
+        {
+            captureDirectory = argv[i + 1];
+        }
+        else if (option == "--headless" && value > 0)
+        {
+            headlessFrameCount = value;
+        }
+        else
+        {
+            std::cerr << "Unknown option: " << option << ' ' << argv[i + 1] << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    lve::FirstApp app{frameSettings, headlessFrameCount, captureDirectory};
 
     try
     {
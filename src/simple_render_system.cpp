@@ -8,6 +8,7 @@
 #include <stdexcept>
 #include <iostream>
 #include <array>
+#include <algorithm>
 
 namespace lve
 {
@@ -27,7 +28,8 @@ namespace lve
 
     SimpleRenderSystem::~SimpleRenderSystem()
     {
-        vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+        lveDevice.deletionQueue().push([device = lveDevice.device(), pipelineLayout = pipelineLayout]()
+                                       { vkDestroyPipelineLayout(device, pipelineLayout, nullptr); });
     }
 
     void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
@@ -73,38 +75,140 @@ namespace lve
             "shaders/simple_shader.vert.spv",
             "shaders/simple_shader.frag.spv",
             pipelineConfig);
+
+        pipelineConfig.bindingDescriptions = LveModel::CompactVertex::getBindingDescriptions();
+        pipelineConfig.attributeDescriptions = LveModel::CompactVertex::getAttributeDescriptions();
+        compactPipeline = std::make_unique<LvePipeline>(
+            lveDevice,
+            "shaders/compact_shader.vert.spv",
+            "shaders/simple_shader.frag.spv",
+            pipelineConfig);
     }
 
     void SimpleRenderSystem::renderGameObjects(
         FrameInfo &frameInfo, std::vector<LveGameObject> &gameObjects)
     {
-        lvePipeline->bind(frameInfo.commandBuffer);
+        recordGameObjects(frameInfo, frameInfo.commandBuffer, gameObjects, 0, gameObjects.size());
+    }
+
+    void SimpleRenderSystem::renderGameObjectsParallel(
+        FrameInfo &frameInfo,
+        std::vector<LveGameObject> &gameObjects,
+        LveRenderer &renderer,
+        LveThreadPool &threadPool)
+    {
+        assert(renderer.getWorkerCount() >= threadPool.getWorkerCount() && "Renderer has too few worker pools.");
 
+        // one batch per worker at most, so every worker records a single secondary
+        const size_t batchCount{std::min<size_t>(
+            threadPool.getWorkerCount(), (gameObjects.size() + PARALLEL_BATCH_SIZE - 1) / PARALLEL_BATCH_SIZE)};
+        if (batchCount == 0)
+        {
+            return;
+        }
+
+        std::vector<VkCommandBuffer> commandBuffers(batchCount);
+        threadPool.parallelFor(
+            static_cast<uint32_t>(batchCount),
+            [&](uint32_t batch, uint32_t worker)
+            {
+                VkCommandBuffer commandBuffer{renderer.beginSecondaryCommandBuffer(worker)};
+                recordGameObjects(
+                    frameInfo,
+                    commandBuffer,
+                    gameObjects,
+                    gameObjects.size() * batch / batchCount,
+                    gameObjects.size() * (batch + 1) / batchCount);
+                renderer.endSecondaryCommandBuffer(commandBuffer);
+                commandBuffers[batch] = commandBuffer;
+            });
+
+        vkCmdExecuteCommands(
+            frameInfo.commandBuffer, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+    }
+
+    // state set here is all a secondary command buffer has, nothing is inherited from the primary
+    void SimpleRenderSystem::recordGameObjects(
+        const FrameInfo &frameInfo,
+        VkCommandBuffer commandBuffer,
+        std::vector<LveGameObject> &gameObjects,
+        size_t first,
+        size_t last)
+    {
         vkCmdBindDescriptorSets(
-            frameInfo.commandBuffer,
+            commandBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             pipelineLayout,
             0,
             1,
             &frameInfo.globalDescriptorSet,
-            0,
-            nullptr);
+            1,
+            &frameInfo.globalUboOffset);
+
+        const glm::mat4 projectionView{frameInfo.camera.getProjection() * frameInfo.camera.getView()};
+        const glm::vec3 cameraPosition{frameInfo.camera.getPosition()};
 
-        for (auto &obj : gameObjects)
+        LvePipeline *boundPipeline{nullptr};
+        LveModel::BindState bindState{};
+        for (size_t i{first}; i < last; ++i)
         {
+            LveGameObject &obj{gameObjects[i]};
+            LvePipeline *pipeline{
+                obj.model->getVertexFormat() == LveModel::VertexFormat::Compact ? compactPipeline.get()
+                                                                                : lvePipeline.get()};
+            if (pipeline != boundPipeline)
+            {
+                pipeline->bind(commandBuffer);
+                boundPipeline = pipeline;
+            }
+
+            const glm::mat4 modelMatrix{obj.transform.mat4()};
+
             SimplePushConstantData push{};
-            push.modelMatrix = obj.transform.mat4();
+            // folding the position decode into the model matrix keeps the shader's decode free
+            push.modelMatrix = modelMatrix * obj.model->getPositionDecode();
             push.normalMatrix = obj.transform.normalMatrix();
 
             vkCmdPushConstants(
-                frameInfo.commandBuffer,
+                commandBuffer,
                 pipelineLayout,
                 VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
                 0,
                 sizeof(SimplePushConstantData),
                 &push);
-            obj.model->bind(frameInfo.commandBuffer);
-            obj.model->draw(frameInfo.commandBuffer);
+            obj.model->bind(commandBuffer, bindState);
+
+            // the pipeline draws back faces, so only frustum culling is safe for these meshlets
+            LveMeshletCuller culler{projectionView, modelMatrix, cameraPosition};
+            obj.model->drawVisible(commandBuffer, culler, selectLod(frameInfo, *obj.model, modelMatrix));
+        }
+    }
+
+    uint32_t SimpleRenderSystem::selectLod(
+        const FrameInfo &frameInfo, const LveModel &model, const glm::mat4 &modelMatrix) const
+    {
+        const auto &lods{model.getLods()};
+
+        // errors grow with the largest axis scale, and are projected at the nearest point of the bounds
+        float maxScale{std::max(
+            std::max(glm::length(glm::vec3{modelMatrix[0]}), glm::length(glm::vec3{modelMatrix[1]})),
+            glm::length(glm::vec3{modelMatrix[2]}))};
+        glm::vec3 center{modelMatrix * glm::vec4{model.getBoundsCenter(), 1.f}};
+        float distance{glm::length(center - frameInfo.camera.getPosition()) - model.getBoundsRadius() * maxScale};
+        if (distance <= 1e-3f)
+        {
+            return 0;
+        }
+
+        float pixelsPerUnit{
+            frameInfo.camera.getProjection()[1][1] * static_cast<float>(frameInfo.extent.height) * 0.5f / distance};
+        for (auto lod{static_cast<uint32_t>(lods.size())}; lod-- > 1;)
+        {
+            if (lods[lod].error * maxScale * pixelsPerUnit <= LOD_PIXEL_ERROR)
+            {
+                return lod;
+            }
         }
+        return 0;
     }
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+// Minimal checks for the CPU side tests, which need neither a device nor a window. A failed
+// check is reported and counted instead of aborting, main returns LVE_TEST_RESULT() for ctest.
+
+namespace lve::test
+{
+    inline int &failureCount()
+    {
+        static int count{0};
+        return count;
+    }
+}
+
+#define LVE_CHECK(condition)                                                                        \
+    do                                                                                              \
+    {                                                                                               \
+        if (!(condition))                                                                           \
+        {                                                                                           \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition "\n";         \
+            ++lve::test::failureCount();                                                            \
+        }                                                                                           \
+    } while (false)
+
+#define LVE_CHECK_EQUAL(actual, expected)                                                           \
+    do                                                                                              \
+    {                                                                                               \
+        const auto &lveActual{actual};                                                              \
+        const auto &lveExpected{expected};                                                          \
+        if (!(lveActual == lveExpected))                                                            \
+        {                                                                                           \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #actual " == " #expected \
+                      << " (" << lveActual << " vs " << lveExpected << ")\n";                       \
+            ++lve::test::failureCount();                                                            \
+        }                                                                                           \
+    } while (false)
+
+#define LVE_TEST_RESULT() (lve::test::failureCount() == 0 ? EXIT_SUCCESS : EXIT_FAILURE)
@@ -0,0 +1,203 @@
+#include "lve_mesh_optimizer.hpp"
+#include "lve_model.hpp"
+#include "lve_test.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Mesh optimizer passes, all on the CPU.
+
+namespace
+{
+    using lve::LveMeshOptimizer;
+    using lve::LveModel;
+
+    using Triangle = std::array<uint32_t, 3>;
+
+    // Grid of quads in the z = 0 plane with its triangles in a shuffled order, a bad case for
+    // the vertex cache.
+    LveModel::Builder makeShuffledGrid(uint32_t quadsPerSide)
+    {
+        LveModel::Builder builder{};
+        for (uint32_t y{0}; y <= quadsPerSide; ++y)
+        {
+            for (uint32_t x{0}; x <= quadsPerSide; ++x)
+            {
+                LveModel::Vertex vertex{};
+                vertex.position = {static_cast<float>(x), static_cast<float>(y), 0.f};
+                builder.vertices.push_back(vertex);
+            }
+        }
+
+        std::vector<Triangle> triangles{};
+        const uint32_t rowLength{quadsPerSide + 1};
+        for (uint32_t y{0}; y < quadsPerSide; ++y)
+        {
+            for (uint32_t x{0}; x < quadsPerSide; ++x)
+            {
+                const uint32_t corner{y * rowLength + x};
+                triangles.push_back({corner, corner + 1, corner + rowLength + 1});
+                triangles.push_back({corner, corner + rowLength + 1, corner + rowLength});
+            }
+        }
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937{42});
+        for (const auto &triangle : triangles)
+        {
+            builder.indices.insert(builder.indices.end(), triangle.begin(), triangle.end());
+        }
+        return builder;
+    }
+
+    // Rotated so the smallest index comes first, which keeps the winding.
+    std::vector<Triangle> sortedTriangles(const std::vector<uint32_t> &indices)
+    {
+        std::vector<Triangle> triangles{};
+        for (size_t i{0}; i + 2 < indices.size(); i += 3)
+        {
+            Triangle triangle{indices[i], indices[i + 1], indices[i + 2]};
+            std::rotate(
+                triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    // Same as sortedTriangles, by position so it survives renumbering the vertices.
+    std::vector<std::array<std::tuple<float, float, float>, 3>> sortedPositions(const LveModel::Builder &builder)
+    {
+        std::vector<std::array<std::tuple<float, float, float>, 3>> triangles{};
+        for (size_t i{0}; i + 2 < builder.indices.size(); i += 3)
+        {
+            std::array<std::tuple<float, float, float>, 3> triangle{};
+            for (size_t corner{0}; corner < 3; ++corner)
+            {
+                const glm::vec3 &position{builder.vertices[builder.indices[i + corner]].position};
+                triangle[corner] = {position.x, position.y, position.z};
+            }
+            std::rotate(
+                triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    // Degenerate triangles at the front, where the overdraw pass's first cluster starts, and
+    // in between.
+    LveModel::Builder makeDegenerateMesh()
+    {
+        LveModel::Builder builder{makeShuffledGrid(4)};
+        const std::vector<uint32_t> degenerate{0, 0, 1, 2, 2, 2};
+        builder.indices.insert(builder.indices.begin(), degenerate.begin(), degenerate.end());
+        builder.indices.insert(builder.indices.begin() + 30, {7, 8, 7});
+        return builder;
+    }
+
+    void testTrianglesPreserved()
+    {
+        for (const auto &source : {makeShuffledGrid(16), makeDegenerateMesh()})
+        {
+            const auto expected{sortedTriangles(source.indices)};
+
+            auto indices{source.indices};
+            LveMeshOptimizer::optimizeVertexCache(indices, source.vertices.size());
+            LVE_CHECK(sortedTriangles(indices) == expected);
+
+            LveMeshOptimizer::optimizeOverdraw(indices, source.vertices);
+            LVE_CHECK_EQUAL(indices.size(), source.indices.size());
+            LVE_CHECK(sortedTriangles(indices) == expected);
+
+            // each pass on its own as well, the overdraw pass sees the degenerate triangle first
+            auto overdrawOnly{source.indices};
+            LveMeshOptimizer::optimizeOverdraw(overdrawOnly, source.vertices);
+            LVE_CHECK(sortedTriangles(overdrawOnly) == expected);
+
+            LveModel::Builder builder{source};
+            LveMeshOptimizer::optimize(builder);
+            LVE_CHECK(sortedPositions(builder) == sortedPositions(source));
+        }
+
+        // nothing but degenerate triangles
+        LveModel::Builder builder{makeShuffledGrid(1)};
+        builder.indices = {0, 0, 1, 2, 3, 3};
+        auto indices{builder.indices};
+        LveMeshOptimizer::optimizeOverdraw(indices, builder.vertices);
+        LVE_CHECK(sortedTriangles(indices) == sortedTriangles(builder.indices));
+        LveMeshOptimizer::optimizeVertexCache(indices, builder.vertices.size());
+        LVE_CHECK(sortedTriangles(indices) == sortedTriangles(builder.indices));
+    }
+
+    void testVertexCacheImproves()
+    {
+        std::vector<LveModel::Builder> meshes{};
+        meshes.push_back(makeShuffledGrid(32));
+        meshes.push_back(makeDegenerateMesh());
+        for (const auto &entry : std::filesystem::directory_iterator{LVE_MODELS_DIR})
+        {
+            if (entry.path().extension() == ".obj")
+            {
+                meshes.emplace_back();
+                meshes.back().loadModel(entry.path().string());
+            }
+        }
+
+        for (auto &mesh : meshes)
+        {
+            const auto before{LveMeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertices.size())};
+            LveMeshOptimizer::optimizeVertexCache(mesh.indices, mesh.vertices.size());
+            const auto after{LveMeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertices.size())};
+            LVE_CHECK(after.acmr <= before.acmr);
+            LVE_CHECK(after.atvr >= 1.f);
+        }
+
+        // a shuffled grid has little reuse left, Tipsify gets back most of it
+        LveModel::Builder grid{makeShuffledGrid(32)};
+        LveMeshOptimizer::optimizeVertexCache(grid.indices, grid.vertices.size());
+        LVE_CHECK(LveMeshOptimizer::analyzeVertexCache(grid.indices, grid.vertices.size()).acmr < 1.f);
+    }
+
+    void testVertexFetchRemap()
+    {
+        LveModel::Builder source{makeDegenerateMesh()};
+        // never referenced, kept at the end
+        LveModel::Vertex unused{};
+        unused.position = {-1.f, -1.f, -1.f};
+        source.vertices.insert(source.vertices.begin() + 3, unused);
+        for (auto &index : source.indices)
+        {
+            index += index >= 3 ? 1 : 0;
+        }
+
+        LveModel::Builder builder{source};
+        LveMeshOptimizer::optimizeVertexFetch(builder.vertices, builder.indices);
+
+        LVE_CHECK_EQUAL(builder.vertices.size(), source.vertices.size());
+        LVE_CHECK_EQUAL(builder.indices.size(), source.indices.size());
+        LVE_CHECK(builder.vertices.back() == unused);
+
+        uint32_t nextNew{0};
+        for (size_t i{0}; i < builder.indices.size(); ++i)
+        {
+            LVE_CHECK(builder.vertices[builder.indices[i]] == source.vertices[source.indices[i]]);
+            // renumbered in first-use order
+            LVE_CHECK(builder.indices[i] <= nextNew);
+            nextNew = std::max(nextNew, builder.indices[i] + 1);
+        }
+    }
+}
+
+int main()
+{
+    testTrianglesPreserved();
+    testVertexCacheImproves();
+    testVertexFetchRemap();
+
+    return LVE_TEST_RESULT();
+}
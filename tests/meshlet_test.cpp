@@ -0,0 +1,239 @@
+#include "lve_camera.hpp"
+#include "lve_mesh_optimizer.hpp"
+#include "lve_mesh_simplifier.hpp"
+#include "lve_meshlet.hpp"
+#include "lve_model.hpp"
+#include "lve_test.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// std
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Meshlet building and culling, all on the CPU.
+
+namespace
+{
+    using lve::LveMeshlet;
+    using lve::LveModel;
+
+    // Grid of quads in the z = 0 plane, counter-clockwise seen from +z unless flipped.
+    LveModel::Builder makeGrid(uint32_t quadsPerSide, bool flipped = false)
+    {
+        LveModel::Builder builder{};
+        for (uint32_t y{0}; y <= quadsPerSide; ++y)
+        {
+            for (uint32_t x{0}; x <= quadsPerSide; ++x)
+            {
+                LveModel::Vertex vertex{};
+                vertex.position = {static_cast<float>(x), static_cast<float>(y), 0.f};
+                vertex.position -= glm::vec3{quadsPerSide * 0.5f, quadsPerSide * 0.5f, 0.f};
+                builder.vertices.push_back(vertex);
+            }
+        }
+        auto addTriangle = [&](uint32_t a, uint32_t b, uint32_t c)
+        {
+            builder.indices.push_back(a);
+            builder.indices.push_back(flipped ? c : b);
+            builder.indices.push_back(flipped ? b : c);
+        };
+        const uint32_t rowLength{quadsPerSide + 1};
+        for (uint32_t y{0}; y < quadsPerSide; ++y)
+        {
+            for (uint32_t x{0}; x < quadsPerSide; ++x)
+            {
+                const uint32_t corner{y * rowLength + x};
+                addTriangle(corner, corner + 1, corner + rowLength + 1);
+                addTriangle(corner, corner + rowLength + 1, corner + rowLength);
+            }
+        }
+        builder.computeBounds();
+        return builder;
+    }
+
+    // Checks the limits, that the meshlets of every level cover each of its triangles exactly
+    // once, and that the spheres contain the vertices.
+    void checkMeshlets(const LveModel::Builder &builder)
+    {
+        LVE_CHECK(!builder.lods.empty());
+        for (const auto &lod : builder.lods)
+        {
+            std::vector<uint32_t> coverage(lod.indexCount / 3, 0);
+            for (uint32_t m{lod.firstMeshlet}; m < lod.firstMeshlet + lod.meshletCount; ++m)
+            {
+                const LveMeshlet &meshlet{builder.meshlets[m]};
+                LVE_CHECK(meshlet.indexCount > 0 && meshlet.indexCount % 3 == 0);
+                LVE_CHECK(meshlet.indexCount / 3 <= LveMeshlet::MAX_TRIANGLES);
+                LVE_CHECK(meshlet.firstIndex >= lod.firstIndex);
+                LVE_CHECK(meshlet.firstIndex + meshlet.indexCount <= lod.firstIndex + lod.indexCount);
+
+                std::vector<uint32_t> meshletVertices(
+                    builder.indices.begin() + meshlet.firstIndex,
+                    builder.indices.begin() + meshlet.firstIndex + meshlet.indexCount);
+                std::sort(meshletVertices.begin(), meshletVertices.end());
+                meshletVertices.erase(
+                    std::unique(meshletVertices.begin(), meshletVertices.end()), meshletVertices.end());
+                LVE_CHECK(meshletVertices.size() <= LveMeshlet::MAX_VERTICES);
+
+                for (auto vertex : meshletVertices)
+                {
+                    const float distance{glm::length(builder.vertices[vertex].position - meshlet.center)};
+                    LVE_CHECK(distance <= meshlet.radius * 1.0001f + 1e-6f);
+                }
+                for (uint32_t i{meshlet.firstIndex}; i < meshlet.firstIndex + meshlet.indexCount; i += 3)
+                {
+                    ++coverage[(i - lod.firstIndex) / 3];
+                }
+            }
+            LVE_CHECK(std::all_of(coverage.begin(), coverage.end(), [](uint32_t count) { return count == 1; }));
+        }
+    }
+
+    void testVertexLimit()
+    {
+        // no shared vertices, so 21 triangles fill a meshlet's 64 vertices
+        LveModel::Builder builder{};
+        for (uint32_t i{0}; i < 300; ++i)
+        {
+            for (uint32_t corner{0}; corner < 3; ++corner)
+            {
+                LveModel::Vertex vertex{};
+                vertex.position = {static_cast<float>(i), static_cast<float>(corner), static_cast<float>(corner % 2)};
+                builder.indices.push_back(static_cast<uint32_t>(builder.vertices.size()));
+                builder.vertices.push_back(vertex);
+            }
+        }
+        builder.computeBounds();
+        builder.buildMeshlets();
+
+        checkMeshlets(builder);
+        LVE_CHECK_EQUAL(builder.meshlets.front().indexCount / 3, LveMeshlet::MAX_VERTICES / 3);
+    }
+
+    void testTriangleLimit()
+    {
+        // 64 vertices and every triangle listed twice, so the triangle limit is reached first
+        LveModel::Builder builder{makeGrid(7)};
+        builder.indices.insert(builder.indices.end(), builder.indices.begin(), builder.indices.end());
+        builder.buildMeshlets();
+
+        checkMeshlets(builder);
+        LVE_CHECK_EQUAL(builder.meshlets.front().indexCount / 3, LveMeshlet::MAX_TRIANGLES);
+        LVE_CHECK_EQUAL(builder.meshlets.size(), size_t{2});
+    }
+
+    void testBundledModels()
+    {
+        for (const auto &entry : std::filesystem::directory_iterator{LVE_MODELS_DIR})
+        {
+            if (entry.path().extension() != ".obj")
+            {
+                continue;
+            }
+            LveModel::Builder builder{};
+            builder.loadModel(entry.path().string());
+            lve::LveMeshOptimizer::optimize(builder);
+            lve::LveMeshSimplifier::generateLods(builder);
+            builder.buildMeshlets();
+
+            std::cout << entry.path().filename().string() << ": " << builder.meshlets.size() << " meshlets in "
+                      << builder.lods.size() << " levels\n";
+            checkMeshlets(builder);
+        }
+    }
+
+    LveMeshlet makeSphere(const glm::vec3 &center, float radius)
+    {
+        LveMeshlet meshlet{};
+        meshlet.center = center;
+        meshlet.radius = radius;
+        return meshlet;
+    }
+
+    void testFrustumRejection()
+    {
+        // at z = -5 looking down +z, the half angle is 25 degrees so x reaches 2.33 at z = 0
+        lve::LveCamera camera{};
+        camera.setPerspectiveProjection(glm::radians(50.f), 1.f, 0.1f, 100.f);
+        camera.setViewTarget(glm::vec3{0.f, 0.f, -5.f}, glm::vec3{0.f});
+        const glm::mat4 projectionView{camera.getProjection() * camera.getView()};
+        const lve::LveMeshletCuller culler{projectionView, glm::mat4{1.f}, camera.getPosition()};
+
+        LVE_CHECK(culler.isVisible(makeSphere({0.f, 0.f, 0.f}, 0.5f)));
+        LVE_CHECK(!culler.isVisible(makeSphere({0.f, 0.f, -10.f}, 1.f)));
+        LVE_CHECK(!culler.isVisible(makeSphere({50.f, 0.f, 0.f}, 1.f)));
+        LVE_CHECK(!culler.isVisible(makeSphere({0.f, -50.f, 0.f}, 1.f)));
+        LVE_CHECK(!culler.isVisible(makeSphere({0.f, 0.f, 200.f}, 1.f)));
+        // straddles the right plane
+        LVE_CHECK(culler.isVisible(makeSphere({2.8f, 0.f, 0.f}, 1.f)));
+
+        // bounds are in model space, the model matrix moves them back into view
+        const lve::LveMeshletCuller movedCuller{
+            projectionView, glm::translate(glm::mat4{1.f}, glm::vec3{50.f, 0.f, 0.f}), camera.getPosition()};
+        LVE_CHECK(movedCuller.isVisible(makeSphere({-50.f, 0.f, 0.f}, 1.f)));
+        LVE_CHECK(!movedCuller.isVisible(makeSphere({0.f, 0.f, 0.f}, 1.f)));
+    }
+
+    void testConeRejection()
+    {
+        lve::LveCamera front{};
+        front.setPerspectiveProjection(glm::radians(50.f), 1.f, 0.1f, 100.f);
+        front.setViewTarget(glm::vec3{0.f, 0.f, 5.f}, glm::vec3{0.f});
+        lve::LveCamera back{};
+        back.setPerspectiveProjection(glm::radians(50.f), 1.f, 0.1f, 100.f);
+        back.setViewTarget(glm::vec3{0.f, 0.f, -5.f}, glm::vec3{0.f});
+
+        auto isVisible = [](const lve::LveCamera &camera, const LveMeshlet &meshlet, bool coneCulling)
+        {
+            return lve::LveMeshletCuller{
+                camera.getProjection() * camera.getView(), glm::mat4{1.f}, camera.getPosition(), coneCulling}
+                .isVisible(meshlet);
+        };
+
+        // a flat patch facing +z has a zero width cone around +z
+        LveModel::Builder builder{makeGrid(4)};
+        builder.buildMeshlets();
+        LVE_CHECK_EQUAL(builder.meshlets.size(), size_t{1});
+        const LveMeshlet &meshlet{builder.meshlets.front()};
+        LVE_CHECK(meshlet.coneCutoff < 1.f);
+        LVE_CHECK(glm::length(meshlet.coneAxis - glm::vec3{0.f, 0.f, 1.f}) < 1e-5f);
+
+        LVE_CHECK(isVisible(front, meshlet, true));
+        LVE_CHECK(!isVisible(back, meshlet, true));
+        LVE_CHECK(isVisible(back, meshlet, false));
+
+        LveModel::Builder flipped{makeGrid(4, true)};
+        flipped.buildMeshlets();
+        LVE_CHECK(!isVisible(front, flipped.meshlets.front(), true));
+        LVE_CHECK(isVisible(back, flipped.meshlets.front(), true));
+
+        // faces over a full hemisphere or more can always be seen, the cone is disabled
+        LveModel::Builder folded{makeGrid(4)};
+        LveModel::Builder folding{makeGrid(4, true)};
+        const auto vertexOffset{static_cast<uint32_t>(folded.vertices.size())};
+        folded.vertices.insert(folded.vertices.end(), folding.vertices.begin(), folding.vertices.end());
+        for (auto index : folding.indices)
+        {
+            folded.indices.push_back(index + vertexOffset);
+        }
+        folded.computeBounds();
+        folded.buildMeshlets();
+        LVE_CHECK_EQUAL(folded.meshlets.front().coneCutoff, 1.f);
+        LVE_CHECK(isVisible(front, folded.meshlets.front(), true));
+        LVE_CHECK(isVisible(back, folded.meshlets.front(), true));
+    }
+}
+
+int main()
+{
+    testVertexLimit();
+    testTriangleLimit();
+    testBundledModels();
+    testFrustumRejection();
+    testConeRejection();
+
+    return LVE_TEST_RESULT();
+}
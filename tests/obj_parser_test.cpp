@@ -0,0 +1,51 @@
+#include "lve_obj_parser.hpp"
+#include "lve_test.hpp"
+#include "tinyobj_reference.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// LveObjParser has to produce exactly what the tinyobj based loader it replaced did: the same
+// vertices bit for bit, in the same order, and the same indices.
+
+int main()
+{
+    std::vector<std::string> modelPaths{};
+    for (const auto &entry : std::filesystem::directory_iterator{LVE_MODELS_DIR})
+    {
+        if (entry.path().extension() == ".obj")
+        {
+            modelPaths.push_back(entry.path().string());
+        }
+    }
+    std::sort(modelPaths.begin(), modelPaths.end());
+    LVE_CHECK(!modelPaths.empty());
+
+    for (const auto &modelPath : modelPaths)
+    {
+        std::vector<lve::LveModel::Vertex> vertices{};
+        std::vector<uint32_t> indices{};
+        lve::LveObjParser{modelPath}.parse(vertices, indices);
+
+        std::vector<lve::LveModel::Vertex> expectedVertices{};
+        std::vector<uint32_t> expectedIndices{};
+        lve::reference::loadWithTinyObj(modelPath, expectedVertices, expectedIndices);
+
+        std::cout << std::filesystem::path{modelPath}.filename().string() << ": " << vertices.size()
+                  << " vertices, " << indices.size() << " indices\n";
+        LVE_CHECK_EQUAL(vertices.size(), expectedVertices.size());
+        LVE_CHECK(vertices.size() != expectedVertices.size() ||
+                  std::memcmp(
+                      vertices.data(),
+                      expectedVertices.data(),
+                      vertices.size() * sizeof(lve::LveModel::Vertex)) == 0);
+        LVE_CHECK_EQUAL(indices.size(), expectedIndices.size());
+        LVE_CHECK(indices == expectedIndices);
+    }
+
+    return LVE_TEST_RESULT();
+}
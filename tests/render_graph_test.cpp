@@ -0,0 +1,148 @@
+#include "lve_render_graph_plan.hpp"
+#include "lve_test.hpp"
+
+// std
+#include <vector>
+
+// Render graph compile results, checked on the plan so no device is needed.
+
+namespace
+{
+    using lve::LveRenderGraphPlan;
+    using lve::LveRenderGraphResource;
+
+    constexpr VkExtent2D SWAP_CHAIN_EXTENT{64, 32};
+
+    // Tightly packed sizes, all in one memory type so any two images may share a slot.
+    LveRenderGraphPlan::RequirementsCallback requirementsOf(const LveRenderGraphPlan &plan, uint32_t &callCount)
+    {
+        return [&plan, &callCount](LveRenderGraphResource index)
+        {
+            ++callCount;
+            const auto &image{plan.getImages()[index]};
+            const VkDeviceSize texelSize{image.info.format == VK_FORMAT_R16G16B16A16_SFLOAT ? 8u : 4u};
+            VkMemoryRequirements requirements{};
+            requirements.size = texelSize * image.extent.width * image.extent.height;
+            requirements.alignment = 256;
+            requirements.memoryTypeBits = 1;
+            return requirements;
+        };
+    }
+
+    void testDeferredFrame()
+    {
+        LveRenderGraphPlan plan{};
+        const LveRenderGraphResource depth{plan.createImage("depth", {VK_FORMAT_D32_SFLOAT})};
+        const LveRenderGraphResource hdr{plan.createImage("hdr", {VK_FORMAT_R16G16B16A16_SFLOAT})};
+        const LveRenderGraphResource debug{plan.createImage("debug", {VK_FORMAT_R8G8B8A8_UNORM})};
+        const LveRenderGraphResource bloom{plan.createImage("bloom", {VK_FORMAT_R16G16B16A16_SFLOAT, {32, 16}})};
+
+        const uint32_t prepass{plan.addPass("depth prepass", [&](auto &builder) { builder.writeDepth(depth); })};
+        const uint32_t main{plan.addPass("main", [&](auto &builder) { builder.writeColor(hdr).writeDepth(depth); })};
+        // nothing reads it, so it goes
+        const uint32_t overlay{plan.addPass("debug overlay", [&](auto &builder) { builder.writeColor(debug); })};
+        const uint32_t bloomPass{plan.addPass("bloom", [&](auto &builder) { builder.read(hdr).writeColor(bloom); })};
+        const uint32_t post{plan.addPass(
+            "post", [&](auto &builder) { builder.read(hdr).read(bloom).writeColor(plan.getBackbuffer()); })};
+
+        uint32_t requirementsCalls{0};
+        plan.compile(SWAP_CHAIN_EXTENT, requirementsOf(plan, requirementsCalls));
+        const auto &passes{plan.getPasses()};
+        const auto &images{plan.getImages()};
+        const auto &stats{plan.getStats()};
+
+        LVE_CHECK_EQUAL(plan.getBackbufferPass(), post);
+        LVE_CHECK_EQUAL(stats.passCount, 5u);
+        LVE_CHECK_EQUAL(stats.culledPassCount, 1u);
+        LVE_CHECK(passes[overlay].culled);
+        LVE_CHECK(!passes[prepass].culled && !passes[main].culled && !passes[bloomPass].culled && !passes[post].culled);
+
+        // the backbuffer and the culled pass's image get no memory
+        LVE_CHECK_EQUAL(requirementsCalls, 3u);
+        LVE_CHECK_EQUAL(stats.transientImageCount, 3u);
+        LVE_CHECK_EQUAL(images[debug].firstPass, LveRenderGraphPlan::NO_PASS);
+        LVE_CHECK_EQUAL(images[depth].extent.width, SWAP_CHAIN_EXTENT.width);
+        LVE_CHECK_EQUAL(images[bloom].extent.width, 32u);
+
+        // depth is done after main, so bloom takes its memory, hdr lives until post
+        LVE_CHECK_EQUAL(stats.memorySlotCount, 2u);
+        LVE_CHECK_EQUAL(images[bloom].slot, images[depth].slot);
+        LVE_CHECK(images[hdr].slot != images[depth].slot);
+        LVE_CHECK_EQUAL(stats.transientBytes, VkDeviceSize{64 * 32 * 4 + 64 * 32 * 8 + 32 * 16 * 8});
+        LVE_CHECK_EQUAL(stats.allocatedBytes, VkDeviceSize{64 * 32 * 4 + 64 * 32 * 8});
+
+        // clear on the first write, store only what a later pass uses
+        LVE_CHECK_EQUAL(passes[prepass].loadOps.size(), size_t{1});
+        LVE_CHECK_EQUAL(passes[prepass].loadOps[0], VK_ATTACHMENT_LOAD_OP_CLEAR);
+        LVE_CHECK_EQUAL(passes[prepass].storeOps[0], VK_ATTACHMENT_STORE_OP_STORE);
+        LVE_CHECK_EQUAL(passes[main].loadOps.size(), size_t{2});
+        LVE_CHECK_EQUAL(passes[main].loadOps[0], VK_ATTACHMENT_LOAD_OP_CLEAR);
+        LVE_CHECK_EQUAL(passes[main].storeOps[0], VK_ATTACHMENT_STORE_OP_STORE);
+        LVE_CHECK_EQUAL(passes[main].loadOps[1], VK_ATTACHMENT_LOAD_OP_LOAD);
+        LVE_CHECK_EQUAL(passes[main].storeOps[1], VK_ATTACHMENT_STORE_OP_DONT_CARE);
+        LVE_CHECK_EQUAL(passes[bloomPass].loadOps[0], VK_ATTACHMENT_LOAD_OP_CLEAR);
+        LVE_CHECK_EQUAL(passes[bloomPass].storeOps[0], VK_ATTACHMENT_STORE_OP_STORE);
+        LVE_CHECK(passes[post].loadOps.empty());
+
+        // depth write after depth write, hdr and bloom from attachment to sampled, and post reading
+        // hdr in the layout bloom left it in needs nothing
+        LVE_CHECK_EQUAL(passes[prepass].barriers.size(), size_t{1});
+        LVE_CHECK_EQUAL(passes[main].barriers.size(), size_t{2});
+        LVE_CHECK_EQUAL(passes[overlay].barriers.size(), size_t{0});
+        LVE_CHECK_EQUAL(passes[bloomPass].barriers.size(), size_t{2});
+        LVE_CHECK_EQUAL(passes[post].barriers.size(), size_t{1});
+        LVE_CHECK_EQUAL(passes[post].barrierImages[0], bloom);
+        LVE_CHECK_EQUAL(stats.imageBarrierCount, 6u);
+        LVE_CHECK_EQUAL(stats.barrierBatchCount, 4u);
+
+        const VkImageMemoryBarrier &depthStart{passes[prepass].barriers[0]};
+        LVE_CHECK_EQUAL(depthStart.oldLayout, VK_IMAGE_LAYOUT_UNDEFINED);
+        LVE_CHECK_EQUAL(depthStart.newLayout, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+        LVE_CHECK_EQUAL(depthStart.subresourceRange.aspectMask, VkImageAspectFlags{VK_IMAGE_ASPECT_DEPTH_BIT});
+
+        // bloom's first use waits for the depth writes it replaces in the shared memory
+        for (size_t i{0}; i < passes[bloomPass].barriers.size(); ++i)
+        {
+            const VkImageMemoryBarrier &barrier{passes[bloomPass].barriers[i]};
+            if (passes[bloomPass].barrierImages[i] == bloom)
+            {
+                LVE_CHECK_EQUAL(barrier.oldLayout, VK_IMAGE_LAYOUT_UNDEFINED);
+                LVE_CHECK_EQUAL(barrier.srcAccessMask, VkAccessFlags{VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT});
+            }
+            else
+            {
+                LVE_CHECK_EQUAL(passes[bloomPass].barrierImages[i], hdr);
+                LVE_CHECK_EQUAL(barrier.newLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            }
+        }
+    }
+
+    void testSideEffects()
+    {
+        LveRenderGraphPlan plan{};
+        const LveRenderGraphResource color{plan.createImage("color", {VK_FORMAT_R8G8B8A8_UNORM})};
+        const LveRenderGraphResource feedback{plan.createImage("feedback", {VK_FORMAT_R8G8B8A8_UNORM})};
+        plan.addPass("kept", [&](auto &builder) { builder.writeColor(color).setSideEffects(); });
+        // only feeds a culled pass, so it is culled as well
+        plan.addPass("source", [&](auto &builder) { builder.writeColor(feedback); });
+        plan.addPass("sink", [&](auto &builder) { builder.read(feedback).writeColor(color); });
+
+        uint32_t requirementsCalls{0};
+        plan.compile(SWAP_CHAIN_EXTENT, requirementsOf(plan, requirementsCalls));
+
+        LVE_CHECK(!plan.getPasses()[0].culled);
+        LVE_CHECK(plan.getPasses()[1].culled && plan.getPasses()[2].culled);
+        LVE_CHECK_EQUAL(plan.getStats().culledPassCount, 2u);
+        LVE_CHECK_EQUAL(requirementsCalls, 1u);
+        // nothing after it uses the image
+        LVE_CHECK_EQUAL(plan.getPasses()[0].storeOps[0], VK_ATTACHMENT_STORE_OP_DONT_CARE);
+    }
+}
+
+int main()
+{
+    testDeferredFrame();
+    testSideEffects();
+
+    return LVE_TEST_RESULT();
+}